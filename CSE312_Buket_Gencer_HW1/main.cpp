@@ -75,55 +75,158 @@
 #include <cmath>
 #include <fcntl.h>
 #include <unistd.h>
+#include <sys/uio.h>
+#include <sys/mman.h>
 #include <stdlib.h>
 #include <climits>
 #include <chrono>
 #include <cstdio>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <algorithm>
+#include <map>
+#include <unordered_map>
+#include <list>
+#include <deque>
+#include <memory>
 
 using namespace std;
-#define MAX_PAGE_TABLE_SIZE 1000000      // maximum page table size in number of entries
-#define MAX_PHYSICAL_MEMORY_SIZE 1000000 // maximum physical memory size in number of entries
+#define MAX_THREADS 64                   // maximum number of simulated processes
+#define PAGE_LOCK_STRIPES 256            // number of locks that the pages are striped over
+#define TLB_SETS 16                      // number of sets of the TLB of a process
+#define TLB_WAYS 4                       // number of entries in one set of the TLB
+#define CLEAN_VICTIM_SCAN 16             // dirty pages the evictor passes over while it looks for a clean victim
+#define READAHEAD_MIN_PAGES 2            // smallest readahead window
+#define READAHEAD_MAX_PAGES 32           // largest readahead window
+#define PAGEOUT_CLUSTER_MAX 32           // largest page-out cluster
+#define MAX_PAGE_LISTS 4                 // lists a replacement policy can keep the pages in
 int globalFrameSize = 0;                 // global frame size
-int virtual_page_number = 0;             // number of virtual pages
+int virtual_page_number = 0;             // number of virtual pages of the array of one process
+int process_page_number = 0;             // number of virtual pages of one process: the array and the scratch pages after it
+int page_table_size = 0;                 // number of page table entries. every process has process_page_number of them
+int numThreads = 1;                      // number of simulated processes
+bool concurrentMode = false;             // true when more than one simulated process runs, enables the locks
+bool sharedAddressSpace = false;         // sort=parallel: the threads are workers that share the pages of process 1
 int physical_memory_size = 0;            // size of physical memory
+int physical_frame_number = 0;           // number of physical frames
 int disk_size = 0;                       // size of disk
 string disk_file_name;                   // disk file name
 int fd;                                  // file descriptor for disk file
+bool mmapDisk = false;                   // the disk file is memory-mapped, pages move to and from it with memcpy
+bool msyncDisk = false;                  // in mmap mode, msync the mapping before the disk is closed
+int *diskMapping = NULL;                 // mapping of the whole disk file in mmap mode
+vector<atomic<unsigned char>> diskPageWritten; // one entry per disk slot of a page, 0 until the page is first written to the disk
 string pageReplacement;                  // page replacement algorithm
-static int clockHand = 0;                // clock hand for clock algorithm
-unsigned int memoryAccessCounter = 0;    // memory access counter
-unsigned int pageTablePrintInt;          // page table print interval
+atomic<unsigned int> memoryAccessCounter(0); // memory access counter
+unsigned int pageTablePrintInt;              // page table print interval
+atomic<unsigned long long> accessTick(0);    // logical clock, advanced on every get/set
+bool tlbEnabled = true;                  // translate through the TLB of the process before the page table
+bool backgroundWriteback = false;        // a flusher thread writes dirty pages back before they are evicted
+bool readaheadEnabled = false;           // a sequential fault also reads the next pages of the process
+int readaheadMaxPages = 0;               // largest readahead window for this physical memory
+int pageoutClusterPages = 1;             // cluster=N: a dirty victim is written with its dirty neighbours, N pages at most
+int zswapPoolPages = 0;                  // zswap=N: modified victims are compressed into a pool of N pages before the disk, 0 is off
+bool asyncFaultIO = false;               // faultio=async: I/O threads read the faulted pages, the workloads start theirs ahead
+int ioDepth = 4;                         // iodepth=N: I/O threads of faultio=async, and the accesses a workload starts ahead
+int diskReadLatencyUs = 0;               // disklatency=N: every disk read takes at least N microseconds, like a device
 
 // declaraiton of functions
 void printPageTable();                                            // print page table
 void initializePageTable();                                       // initialize page table
 void printPhysicalMemory();                                       // print physical memory
 void initializePhysicalMemory();                                  // initialize physical memory
+int allocateFrame();                                              // take a free frame from the free frame stack
+void releaseFrame(int frameNumber);                               // give a frame back to the free frame stack
+void releasePage(int pageIndex);                                  // drop a page and its content, its frame becomes free
+bool checkFrameTable();                                           // check=on: check the frame table and the free frame stack
 void fillVirtualMemory(uint32_t threadNum);                       // fill virtual memory with random integers
 void set(unsigned int threadNum, unsigned int index, int value);  // set the value of the data at the given index in the virtual memory
 void initializeDisk();                                            // initialize disk
 void printDisk();                                                 // print disk
+void closeDisk();                                                 // close the disk file, and unmap it in mmap mode
 int get(unsigned int threadNum, unsigned int index);              // get the value of the data at the given index in the virtual memory
 void merge(unsigned int threadNum, int left, int mid, int right); // merge function for merge sort
 void mergeSort(unsigned int threadNum, int left, int right);      // merge sort function
 int binarySearch(int threadNum, int l, int r, int x);             // binary search function
+void externalMergeSort(unsigned int threadNum);                   // page-aware external merge sort of the array of a process
+void writePageToDisk(unsigned int threadNum, int pageIndex, int frameNumber);  // write a whole frame to the disk slot of a page
+void getRange(unsigned int threadNum, unsigned int index, unsigned int count, int *buffer);        // copy count integers from the virtual memory to buffer
+void setRange(unsigned int threadNum, unsigned int index, unsigned int count, const int *buffer);  // copy count integers from buffer to the virtual memory
+void queueDirtyPage(int pageIndex);                               // put a page that became modified on the dirty page queue of the flusher
 // declaraiton of struct
-struct PageTableEntry;      // page table entry
-struct physicalMemoryEntry; // physical memory entry
+struct PageTableEntry; // page table entry
+struct FrameInfo;      // physical frame metadata
 
-int applyLRUReplacement(vector<PageTableEntry> &pageTable, vector<physicalMemoryEntry> &physicalMemory, int fd, int globalFrameSize, int virtual_page_number);
-int applyClockReplacement(vector<PageTableEntry> &pageTable, vector<physicalMemoryEntry> &physicalMemory, int fd, int globalFrameSize, int virtual_page_number, int &clockHand);
+// layout of a page table entry
+#define PTE_FRAME_MASK 0xFFFFFFULL      // bits 0-23: frame number in physical memory, all ones for no frame
+#define PTE_VALID (1ULL << 24)          // valid bit
+#define PTE_MODIFIED (1ULL << 25)       // modified bit
+#define PTE_REFERENCED (1ULL << 26)     // referenced bit
+#define PTE_IN_TRANSIT (1ULL << 27)     // set while the page is being read from or written to the disk
+#define PTE_WRITEBACK (1ULL << 28)      // set while the flusher or a page-out cluster writes a copy of the page to the disk, the page can not be evicted
+#define PTE_PREFETCHED (1ULL << 29)     // set if the page was read ahead and has not been accessed yet
+#define PTE_AGE_SHIFT 32                // bits 32-39: age of the page for the AGING policy
+#define PTE_AGE_MASK 0xFFULL
+#define PTE_TIME_SHIFT 40               // bits 40-63: low 24 bits of accessTick at the last access that walked the page table
+#define PTE_TIME_MASK 0xFFFFFFULL
 
-// page table entry
+// page table entry, packed in one 64 bit word. the word is only changed while the lock of the page is held,
+// it is atomic so a reader that only holds the pager lock, like the LRU policy checking the valid bit, does
+// not race with a change of another bit of the same entry
 struct PageTableEntry
 {
-    int frameNumber;       // frame number in physical memory
-    int valid;             // valid bit
-    int modified;          // modified bit
-    int referenced;        // referenced bit
-    time_t lastAccessTime; // last access time in nano seconds for LRU
+    atomic<unsigned long long> bits;
+
+    PageTableEntry() : bits(PTE_FRAME_MASK) {}
+
+    unsigned long long load() const { return bits.load(memory_order_relaxed); }
+    void store(unsigned long long value) { bits.store(value, memory_order_relaxed); }
+    int test(unsigned long long flag) const { return (load() & flag) != 0; }
+    void assign(unsigned long long flag, int on) { store(on ? (load() | flag) : (load() & ~flag)); }
+
+    int frameNumber() const
+    {
+        unsigned long long frame = load() & PTE_FRAME_MASK;
+        return frame == PTE_FRAME_MASK ? -1 : (int)frame;
+    }
+    void setFrameNumber(int frameNumber) { store((load() & ~PTE_FRAME_MASK) | ((unsigned long long)frameNumber & PTE_FRAME_MASK)); }
+    int valid() const { return test(PTE_VALID); }
+    void setValid(int on) { assign(PTE_VALID, on); }
+    int modified() const { return test(PTE_MODIFIED); }
+    void setModified(int on) { assign(PTE_MODIFIED, on); }
+    int referenced() const { return test(PTE_REFERENCED); }
+    void setReferenced(int on) { assign(PTE_REFERENCED, on); }
+    int inTransit() const { return test(PTE_IN_TRANSIT); }
+    void setInTransit(int on) { assign(PTE_IN_TRANSIT, on); }
+    int writeback() const { return test(PTE_WRITEBACK); }
+    void setWriteback(int on) { assign(PTE_WRITEBACK, on); }
+    int prefetched() const { return test(PTE_PREFETCHED); }
+    void setPrefetched(int on) { assign(PTE_PREFETCHED, on); }
+    unsigned int age() const { return (load() >> PTE_AGE_SHIFT) & PTE_AGE_MASK; }
+    void setAge(unsigned int age) { store((load() & ~(PTE_AGE_MASK << PTE_AGE_SHIFT)) | ((age & PTE_AGE_MASK) << PTE_AGE_SHIFT)); }
+    unsigned int lastAccessTime() const { return (load() >> PTE_TIME_SHIFT) & PTE_TIME_MASK; }
+    void setLastAccessTime(unsigned long long tick) { store((load() & ~(PTE_TIME_MASK << PTE_TIME_SHIFT)) | ((tick & PTE_TIME_MASK) << PTE_TIME_SHIFT)); }
 };
 
+// ticks of accessTick from a last access time of a page table entry to now. the entry only keeps the low bits
+// of the tick, so the result is exact for pages used in the last 2^24 ticks
+inline unsigned int ticksSince(unsigned int lastAccessTime, unsigned long long now)
+{
+    return (now - lastAccessTime) & PTE_TIME_MASK;
+}
+
+// true if the simulator can hold threads processes of pages virtual pages each and physicalFrames frames, all
+// of frameSize integers: page numbers, disk offsets and physical memory offsets are ints, and a frame number
+// has to fit in a page table entry
+bool simulationFits(long long frameSize, long long pages, long long threads, long long physicalFrames)
+{
+    return pages * threads <= INT_MAX &&
+           pages * frameSize * max(2LL, threads) <= INT_MAX &&
+           physicalFrames < (long long)PTE_FRAME_MASK &&
+           physicalFrames * frameSize <= INT_MAX;
+}
+
 // statistics structure
 struct Statistics
 {
@@ -134,661 +237,5264 @@ struct Statistics
     unsigned int diskPageWrites;
     unsigned int diskPageReads;
     unsigned int physicalFramesInMemory;
+    unsigned int tlbHits;
+    unsigned int tlbMisses;
+    unsigned int backgroundPageWrites; // pages of the process written back by the flusher thread
+    unsigned int prefetchedPages;      // pages read ahead of a sequential fault
+    unsigned int prefetchHits;         // read ahead pages that were accessed before their eviction
+    unsigned int wastedPrefetches;     // read ahead pages that were evicted without an access
+    unsigned int diskWriteOperations;  // pwrite and pwritev calls of the disk page writes
+    unsigned int firstTouchPages;      // faults on pages that were never written, filled in memory without a disk read
+    unsigned int zswapStores;          // modified victims compressed into the zswap pool instead of written to the disk
+    unsigned int zswapLoads;           // faults served from the zswap pool instead of the disk
+    unsigned int zswapWritebacks;      // pool pages written to the disk to make room in the pool
+    unsigned int zswapRejects;         // modified victims that did not get smaller and were written to the disk
+    unsigned int asyncPageIns;         // page-ins started ahead of their access and read by the I/O threads
+    unsigned int parkedPageIns;        // faults parked while an I/O thread read their page
+    unsigned long long zswapStoredBytes;     // size of the pages stored in the pool
+    unsigned long long zswapCompressedBytes; // their size in the pool
+};
+
+// statistics of one simulated process. every process updates only its own entry, on its own cache line
+struct alignas(64) ThreadStatistics
+{
+    Statistics stats;
 };
 
-// global statistics array
-Statistics statsOfProgram = {0, 0, 0, 0, 0, 0, 0};
+// per process statistics, indexed by thread number. entry 0 is not used
+ThreadStatistics threadStats[MAX_THREADS + 1];
 
-// page table
-vector<PageTableEntry> pageTable(MAX_PAGE_TABLE_SIZE); // page table
+// pages of every process that the flusher thread wrote back. a process copies its statistics while the flusher
+// runs, so the flusher does not write them; mergeStatistics moves these counters into them
+atomic<unsigned int> backgroundPageWrites[MAX_THREADS + 1];
 
-void printStatistics()
+// telemetry=file: counters that the sampler thread reads while the processes run. every counter has one writer,
+// which adds with a relaxed load and store instead of a locked add, so counting costs as much as for the
+// statistics. entry 0 is the flusher thread
+#define TELEMETRY_LATENCY_BUCKETS 32 // bucket b of the fault latency histogram counts the faults of [2^b, 2^(b+1)) ns
+struct alignas(64) TelemetryCounters
 {
-    // print the statistics in a table format
-    printf("┌───────────────────────────────┬────────────┐\n");
-    printf("│ Statistic                     │ Value      │\n");
-    printf("├───────────────────────────────┼────────────┤\n");
-    printf("│ Reads                         │ %10u │\n", statsOfProgram.reads);
-    printf("│ Writes                        │ %10u │\n", statsOfProgram.writes);
-    printf("│ Page Misses                   │ %10u │\n", statsOfProgram.pageMisses);
-    printf("│ Page Replacements             │ %10u │\n", statsOfProgram.pageReplacements);
-    printf("│ Disk Page Writes              │ %10u │\n", statsOfProgram.diskPageWrites);
-    printf("│ Disk Page Reads               │ %10u │\n", statsOfProgram.diskPageReads);
-    printf("│ Physical Frames In Memory     │ %10u │\n", statsOfProgram.physicalFramesInMemory);
-    printf("└───────────────────────────────┴────────────┘\n");
-}
+    atomic<unsigned long long> accesses;       // integers read and written
+    atomic<unsigned long long> faults;         // accesses that did not find their page in the physical memory
+    atomic<unsigned long long> diskPageReads;  // disk page reads of the process at its last fault
+    atomic<unsigned long long> diskPageWrites; // disk page writes of the process at its last fault, of the flusher in entry 0
+    atomic<unsigned long long> faultLatency[TELEMETRY_LATENCY_BUCKETS];
+};
+TelemetryCounters telemetry[MAX_THREADS + 1];
+bool telemetryEnabled = false; // the sampler thread runs, the counters are updated
 
-// page table print function
-void printPageTable()
+// add to a telemetry counter. only one thread writes a counter
+inline void telemetryAdd(atomic<unsigned long long> &counter, unsigned long long value)
 {
-    // print the page table entries
-    printf("┌──────────────┬──────────────┬────────┬─────────┬───────────┬────────────────────┐\n");
-    printf("│ Page Table   │ Frame Number │ Valid  │ Modified│ Referenced│ Last Access Time   │\n");
-    printf("├──────────────┼──────────────┼────────┼─────────┼───────────┼────────────────────┤\n");
+    counter.store(counter.load(memory_order_relaxed) + value, memory_order_relaxed);
+}
 
-    // print the page table entries for each page
-    for (int i = 0; i < virtual_page_number; i++)
-    {
-        printf("│ Entry %2d     │ %12d │ %6d │ %8d │ %9d │ %18ld │\n",
-               i,
-               pageTable[i].frameNumber,
-               pageTable[i].valid,
-               pageTable[i].modified,
-               pageTable[i].referenced,
-               static_cast<long>(pageTable[i].lastAccessTime));
-    }
+// statistics of all processes, merged at the end of the run
+Statistics statsOfProgram = Statistics();
 
-    // print the end of the page table
-    printf("└──────────────┴──────────────┴────────┴─────────┴───────────┴────────────────────┘\n");
-}
+// page locks. page p is protected by pageLocks[p % PAGE_LOCK_STRIPES]. threads that find a page in transit
+// wait on transitDone of its stripe. pagerMutex protects the free frame stack, the frame table and the
+// state of the replacement algorithms. when both are needed pagerMutex is locked first.
+struct alignas(64) PageLock
+{
+    mutex lock;
+    condition_variable transitDone;
+};
 
-// initialize the page table
-void initializePageTable()
+PageLock pageLocks[PAGE_LOCK_STRIPES];
+mutex pagerMutex;
+
+// lock stripe of a page
+inline PageLock &pageLockOf(int pageIndex)
 {
-    for (int i = 0; i < virtual_page_number; i++)
-    {
-        pageTable[i].frameNumber = -1; // if -1 then it is not in physical memory.
-        pageTable[i].valid = 0;
-        pageTable[i].modified = 0;
-        pageTable[i].referenced = 0;
-        pageTable[i].lastAccessTime = 0;
-    }
+    return pageLocks[pageIndex % PAGE_LOCK_STRIPES];
 }
 
-// physical memory entry
-struct physicalMemoryEntry
+// software TLB of one process. it caches page -> frame translations so a hit does not touch the page table.
+// page p can only be in set p % TLB_SETS. an entry packs (page + 1) << 32 | dirty << 31 | frame, 0 is an
+// empty entry. the dirty bit tells that the modified bit of the page is already set, like the D bit of a
+// hardware TLB. only the owner process fills its TLB, but evictions of other processes invalidate entries,
+// so the entries are atomic. an entry of page p is only read or changed while the lock of page p is held.
+struct alignas(64) TLB
 {
-    int data;      // random integer
-    int threadNum; // thread number that the data belongs to . 1 or 2
-    int diskIndex; // if the data is not in physical memory, then it is in disk. diskIndex is the index of the data in the disk.
+    atomic<unsigned long long> entries[TLB_SETS][TLB_WAYS];
+    unsigned int nextWay[TLB_SETS]; // round robin replacement inside every set
 };
 
-// physical memory entries vector
-vector<physicalMemoryEntry> physicalMemory; // physical memory
+#define TLB_DIRTY_BIT (1ULL << 31)
 
-void initializePhysicalMemory()
-{
-    // check if physical memory is null
+TLB tlbs[MAX_THREADS + 1]; // TLB of every process, indexed by thread number
 
-    for (int i = 0; i < physical_memory_size; i++)
+// empty every TLB
+void initializeTLBs()
+{
+    for (int t = 0; t <= MAX_THREADS; t++)
     {
-        // use push back to add the physical memory entries
-        physicalMemory.push_back({-1, -1, -1});
+        for (int set = 0; set < TLB_SETS; set++)
+        {
+            for (int way = 0; way < TLB_WAYS; way++)
+            {
+                tlbs[t].entries[set][way].store(0, memory_order_relaxed);
+            }
+            tlbs[t].nextWay[set] = 0;
+        }
     }
 }
 
-// print physical memory
-void printPhysicalMemory()
+// find the TLB entry of a page. returns the way of the entry, -1 on a TLB miss
+inline int tlbLookup(unsigned int threadNum, int pageIndex, unsigned long long &entry)
 {
-    // print physical memory entries
-    for (int i = 0; i < physical_memory_size; i++)
+    unsigned long long tag = (unsigned long long)(pageIndex + 1) << 32;
+    atomic<unsigned long long> *set = tlbs[threadNum].entries[pageIndex % TLB_SETS];
+    // compare every way without an early exit, the way of a hit is not predictable
+    int found = -1;
+    for (int way = 0; way < TLB_WAYS; way++)
     {
-        cout << "Physical Memory Entry " << i << ": ";                    // entry means every integer in the physical memory
-        cout << "Data: " << physicalMemory[i].data << ", ";               // data is the random integer
-        cout << "Thread Number: " << physicalMemory[i].threadNum << ", "; // thread number that the data belongs to
-        cout << "Disk Index: " << physicalMemory[i].diskIndex << endl;    // if the data is not in physical memory, then it is in disk. diskIndex is the index of the data in the disk.
+        unsigned long long candidate = set[way].load(memory_order_relaxed);
+        bool match = (candidate & ~0xFFFFFFFFULL) == tag;
+        found = match ? way : found;
+        entry = match ? candidate : entry;
     }
+    return found;
+}
 
-    /* print every begin of the frame
-    for (int i = 0; i < physical_memory_size; i += globalFrameSize)
+// cache the translation of a page that was just found in the page table
+inline void tlbInsert(unsigned int threadNum, int pageIndex, int frameNumber, bool dirty)
+{
+    TLB &tlb = tlbs[threadNum];
+    int set = pageIndex % TLB_SETS;
+    int way = tlb.nextWay[set];
+    tlb.nextWay[set] = (way + 1) % TLB_WAYS;
+    tlb.entries[set][way].store(((unsigned long long)(pageIndex + 1) << 32) | (dirty ? TLB_DIRTY_BIT : 0) | (unsigned int)frameNumber, memory_order_relaxed);
+}
+
+// remove the translation of a page from the TLB of the process that owns the page, from the TLB of every worker
+// in a shared address space. the caller holds the page lock
+inline void tlbInvalidate(int pageIndex)
+{
+    unsigned int owner = pageIndex / process_page_number + 1;
+    unsigned int lastOwner = sharedAddressSpace ? numThreads : owner;
+    for (unsigned int t = owner; t <= lastOwner; t++)
     {
-        cout << "Frame " << i / globalFrameSize << ": "; // frame number
-        for (int j = 0; j < globalFrameSize; j++)        // print the data in the frame
-        {
-            cout << physicalMemory[i + j].data << " "; // data is the random integer
-        }
-        cout << endl;
+        unsigned long long entry;
+        int way = tlbLookup(t, pageIndex, entry);
+        if (way != -1)
+            tlbs[t].entries[pageIndex % TLB_SETS][way].store(0, memory_order_relaxed);
     }
-    */
 }
 
-// fill the virtual memory with tasks: fill the entire virtual memory with random integers. use the same random numbers for all runs of the program.
-void fillVirtualMemory(uint32_t threadNum)
+// clear the dirty bit of the TLB entries of a page, so the next write through one of them sets the modified bit
+// again. the caller holds the page lock
+inline void tlbClearDirty(int pageIndex)
 {
-    // fillVirtualMemory function is used to fill the entire virtual memory with random integers.
-    // before filling the virtual memory, call srand(1000) for thread 1 and call srand(2000) for thread 2
-
-    // srand(1000) for thread 1 and srand(2000) for thread 2
-    srand(1000);
-
-    // size of the virtual memory
-    size_t size = virtual_page_number * globalFrameSize;
-
-    // according to thread nume fill the virtual memory with random integers
-
-    for (size_t i = 0; i < size; i++)
+    unsigned int owner = pageIndex / process_page_number + 1;
+    unsigned int lastOwner = sharedAddressSpace ? numThreads : owner;
+    for (unsigned int t = owner; t <= lastOwner; t++)
     {
-        // generate random integer
-        int randomValue = rand() % 1000; // random integer
-        // set the value of the data in the virtual memory
-        set(threadNum, i, randomValue);
+        unsigned long long entry;
+        int way = tlbLookup(t, pageIndex, entry);
+        if (way != -1)
+            tlbs[t].entries[pageIndex % TLB_SETS][way].store(entry & ~TLB_DIRTY_BIT, memory_order_relaxed);
     }
 }
 
-// Function to apply the Clock Replacement Algorithm
-int applyClockReplacement(vector<PageTableEntry> &pageTable, vector<physicalMemoryEntry> &physicalMemory, int fd, int globalFrameSize, int virtual_page_number, int &clockHand)
+// organisation of the page table, selected with pagetable=flat|radix|inverted
+enum PageTableMode
 {
-    while (true)
-    {
-        // If Referenced bit is 0 and Valid bit is 1, then evict the page. Otherwise, set the Referenced bit to 0.
-        if (pageTable[clockHand].valid && pageTable[clockHand].referenced == 0)
-        {
-            int frameNumber = pageTable[clockHand].frameNumber;
+    PAGE_TABLE_FLAT,    // one entry for every virtual page
+    PAGE_TABLE_RADIX,   // three level radix tree, a leaf is allocated when the first of its pages is faulted
+    PAGE_TABLE_INVERTED // hash table with entries only for the pages that are resident or in transit
+};
+PageTableMode pageTableMode = PAGE_TABLE_FLAT; // organisation of the page table of the next simulation
 
-            // ıf page is modified, write it to the disk
-            if (pageTable[clockHand].modified)
-            {
-                vector<int> data(globalFrameSize);
-                for (uint32_t j = 0; j < globalFrameSize; ++j)
-                {
-                    data[j] = physicalMemory[frameNumber * globalFrameSize + j].data;
-                }
+#define RADIX_LEAF_BITS 9   // a leaf holds 2^9 entries of 8 bytes, a 4 KB page
+#define RADIX_MIDDLE_BITS 11 // a middle directory points to 2^11 leaves
 
-                int pos = clockHand * globalFrameSize; // calculate the position with using clock hand and global frame size
-                // increade the number of disk page writes
-                statsOfProgram.diskPageWrites++;
-                lseek(fd, pos * sizeof(int), SEEK_SET);
-                write(fd, &data[0], globalFrameSize * sizeof(int)); // write the data to the disk
-            }
+// leaf of the radix page table
+struct RadixLeaf
+{
+    PageTableEntry entries[1 << RADIX_LEAF_BITS];
+};
 
-            // update the page table entry for the evicted page
-            pageTable[clockHand].valid = 0;
-            pageTable[clockHand].modified = 0;
-            pageTable[clockHand].referenced = 0;
-            pageTable[clockHand].lastAccessTime = 0;
-            pageTable[clockHand].frameNumber = -1;
+// middle directory of the radix page table. a leaf pointer is set once, with a compare and swap
+struct RadixDirectory
+{
+    atomic<RadixLeaf *> leaves[1 << RADIX_MIDDLE_BITS];
 
-            int evictedFrame = frameNumber;
+    RadixDirectory()
+    {
+        for (int i = 0; i < (1 << RADIX_MIDDLE_BITS); i++)
+            leaves[i].store(NULL, memory_order_relaxed);
+    }
+};
 
-            // update the clock hand for the next page
-            clockHand = (clockHand + 1) % virtual_page_number;
+// entry of the inverted page table, on the chain of its bucket or on the free list
+struct InvertedNode
+{
+    PageTableEntry entry;
+    int pageIndex; // page of the entry, -1 while the node is free
+    int next;      // next node of the chain, -1 at its end
+};
 
-            return evictedFrame;
-        }
+// the page table. every organisation gives the entry of a page with operator[]. a page that has no entry, an
+// untouched page of the radix tree or a page that is not resident or in transit in the inverted table, gets
+// the shared empty entry, which is never changed. an entry is only created where a page goes in transit, and
+// the inverted table drops an entry as soon as it is empty again.
+//
+// the buckets of the inverted table follow the page lock stripes: every page of a bucket has the same page
+// lock, so a chain is walked and changed while the page lock of the page is held, like a flat entry.
+struct PageTable
+{
+    PageTableMode mode;
+    int size;                              // number of virtual pages of all processes
+    unique_ptr<PageTableEntry[]> flat;     // flat: entry of every page
+    int directoryCount;                    // radix: number of middle directories
+    unique_ptr<atomic<RadixDirectory *>[]> directories; // radix: top level, a middle directory is allocated on demand
+    atomic<int> leafCount;                 // radix: allocated leaves
+    int capacity;                          // inverted: number of nodes
+    unique_ptr<InvertedNode[]> nodes;      // inverted: node pool
+    vector<int> buckets;                   // inverted: first node of every chain, -1 for an empty chain
+    int bucketGroupBits;                   // inverted: there are 2^bucketGroupBits buckets for every page lock stripe
+    int freeNode;                          // inverted: first node of the free list
+    mutex freeMutex;                       // inverted: protects the free list. locked after any page lock
+    PageTableEntry empty;                  // entry of a page that has none
 
-        // If referenced bit is 1, set it to 0 and move to the next page
-        pageTable[clockHand].referenced = 0;
-        clockHand = (clockHand + 1) % virtual_page_number;
-    }
-}
+    PageTable() : mode(PAGE_TABLE_FLAT), size(0), directoryCount(0), leafCount(0), capacity(0), bucketGroupBits(0), freeNode(-1) {}
 
-// Function to apply the LRU Replacement Algorithm
-int applyLRUReplacement(vector<PageTableEntry> &pageTable, vector<physicalMemoryEntry> &physicalMemory, int fd, int globalFrameSize, int virtual_page_number)
-{
-    long long minTime = LLONG_MAX;
-    int lruPage = -1;
+    ~PageTable() { clearRadix(); }
 
-    // Find the least recently used page
-    for (int i = 0; i < virtual_page_number; ++i)
+    void clearRadix()
     {
-        if (pageTable[i].valid && pageTable[i].lastAccessTime < minTime)
+        for (int d = 0; d < directoryCount; d++)
         {
-            minTime = pageTable[i].lastAccessTime;
-            lruPage = i;
+            RadixDirectory *directory = directories[d].load(memory_order_relaxed);
+            if (directory == NULL)
+                continue;
+            for (int l = 0; l < (1 << RADIX_MIDDLE_BITS); l++)
+                delete directory->leaves[l].load(memory_order_relaxed);
+            delete directory;
         }
+        directories.reset();
+        directoryCount = 0;
+        leafCount = 0;
     }
 
-    int frameNumber = pageTable[lruPage].frameNumber;
-
-    // Page replacement and disk index update
-    if (pageTable[lruPage].modified)
+    // set up an empty table of pageCount pages. the inverted table gets nodeCount nodes
+    void init(PageTableMode tableMode, int pageCount, int nodeCount)
     {
-        vector<int> data;
-        for (uint32_t j = 0; j < globalFrameSize; ++j)
+        clearRadix();
+        flat.reset();
+        nodes.reset();
+        buckets.clear();
+        mode = tableMode;
+        size = pageCount;
+        if (mode == PAGE_TABLE_FLAT)
         {
-            data.push_back(physicalMemory[frameNumber * globalFrameSize + j].data);
+            flat.reset(new PageTableEntry[size]);
         }
-
-        // find the position of the page in the disk
-        int pos = lruPage * globalFrameSize;
-        // increase the number of disk page writes
-        statsOfProgram.diskPageWrites++;
-        lseek(fd, pos * sizeof(int), SEEK_SET);
-        write(fd, &data[0], globalFrameSize * sizeof(int));
-
-        // update the disk index
-        for (uint32_t j = 0; j < globalFrameSize; ++j)
+        else if (mode == PAGE_TABLE_RADIX)
+        {
+            directoryCount = ((long long)size + (1LL << (RADIX_LEAF_BITS + RADIX_MIDDLE_BITS)) - 1) >> (RADIX_LEAF_BITS + RADIX_MIDDLE_BITS);
+            directories.reset(new atomic<RadixDirectory *>[directoryCount]);
+            for (int d = 0; d < directoryCount; d++)
+                directories[d].store(NULL, memory_order_relaxed);
+        }
+        else
         {
-            physicalMemory[frameNumber * globalFrameSize + j].diskIndex = pos + j;
+            capacity = nodeCount;
+            nodes.reset(new InvertedNode[capacity]);
+            for (int n = 0; n < capacity; n++)
+            {
+                nodes[n].pageIndex = -1;
+                nodes[n].next = n + 1 < capacity ? n + 1 : -1;
+            }
+            freeNode = 0;
+            // about two buckets for every node
+            bucketGroupBits = 0;
+            while ((PAGE_LOCK_STRIPES << bucketGroupBits) < 2 * capacity)
+                bucketGroupBits++;
+            buckets.assign(PAGE_LOCK_STRIPES << bucketGroupBits, -1);
         }
     }
 
-    pageTable[lruPage].valid = 0;
-    pageTable[lruPage].modified = 0; //???
-    pageTable[lruPage].referenced = 0;
-    pageTable[lruPage].lastAccessTime = 0;
-    pageTable[lruPage].frameNumber = -1;
-    return frameNumber; // LRU return the frame number that will be replaced
-}
-
-// set function to set the value of the data at the given index in the virtual memory
-void set(unsigned int threadNum, unsigned int index, int value)
-{
-
-    // increase the write counter
-    statsOfProgram.writes++;
-    int pageIndex = index / globalFrameSize; // which page the index belongs to
-    int offset = index % globalFrameSize;    // offset of the index in the page
-
-    // current time in microseconds
-    auto now = std::chrono::steady_clock::now();
-    auto now_us = std::chrono::time_point_cast<std::chrono::microseconds>(now);
-    long long time_in_us = now_us.time_since_epoch().count();
-
-    if (pageTable[pageIndex].valid) // check if the page is in the physical memory
+    // bucket of a page. pages of a bucket have the same page lock stripe
+    inline int bucketOf(int pageIndex) const
     {
-        int frameNumber = pageTable[pageIndex].frameNumber;
-        physicalMemory[frameNumber * globalFrameSize + offset].data = value;
-        physicalMemory[frameNumber * globalFrameSize + offset].threadNum = threadNum;
-        physicalMemory[frameNumber * globalFrameSize + offset].diskIndex = index;
-
-        // update the page table entry
-        pageTable[pageIndex].modified = 1;
-        pageTable[pageIndex].referenced = 1;
-        pageTable[pageIndex].lastAccessTime = time_in_us;
+        unsigned int group = bucketGroupBits == 0 ? 0 : ((unsigned int)(pageIndex / PAGE_LOCK_STRIPES) * 2654435761u) >> (32 - bucketGroupBits);
+        return (int)(group * PAGE_LOCK_STRIPES) + pageIndex % PAGE_LOCK_STRIPES;
     }
-    else
-    {
-        int allocated = 0;
-        int frameNumber = -1;
 
-        // Find an empty frame in the physical memory
-        for (uint32_t i = 0; i < physical_memory_size; i += globalFrameSize)
+    // leaf of a page in the radix tree. with allocate a missing directory or leaf is made, else NULL is returned
+    RadixLeaf *leafOf(int pageIndex, bool allocate)
+    {
+        atomic<RadixDirectory *> &top = directories[pageIndex >> (RADIX_LEAF_BITS + RADIX_MIDDLE_BITS)];
+        RadixDirectory *directory = top.load(memory_order_acquire);
+        if (directory == NULL)
         {
-            bool frameEmpty = true;
-            for (uint32_t j = 0; j < globalFrameSize; ++j)
-            {
-                if (physicalMemory[i + j].threadNum != -1)
-                {
-                    frameEmpty = false;
-                    break;
-                }
-            }
-            if (frameEmpty) // if the frame is empty
-            {
-                frameNumber = i / globalFrameSize;
-                physicalMemory[frameNumber * globalFrameSize + offset].data = value;
-                physicalMemory[frameNumber * globalFrameSize + offset].threadNum = threadNum;
-                physicalMemory[frameNumber * globalFrameSize + offset].diskIndex = -1;
-
-                pageTable[pageIndex].frameNumber = frameNumber;
-                pageTable[pageIndex].valid = 1;
-                pageTable[pageIndex].modified = 1;
-                pageTable[pageIndex].referenced = 1;
-                pageTable[pageIndex].lastAccessTime = time_in_us;
-                allocated = 1;
-                break;
-            }
+            if (!allocate)
+                return NULL;
+            RadixDirectory *fresh = new RadixDirectory();
+            if (top.compare_exchange_strong(directory, fresh, memory_order_acq_rel))
+                directory = fresh;
+            else
+                delete fresh; // another process installed it first, directory holds its pointer
         }
-        // when the page fault occurs
-        if (!allocated)
+
+        atomic<RadixLeaf *> &middle = directory->leaves[(pageIndex >> RADIX_LEAF_BITS) & ((1 << RADIX_MIDDLE_BITS) - 1)];
+        RadixLeaf *leaf = middle.load(memory_order_acquire);
+        if (leaf == NULL)
         {
-            if (pageReplacement == "LRU")
-            {
-                frameNumber = applyLRUReplacement(pageTable, physicalMemory, fd, globalFrameSize, virtual_page_number);
-                // increase the number of page replacements
-                statsOfProgram.pageReplacements++;
-                // increase the number of page misses
-                statsOfProgram.pageMisses++;
-            }
-            else if (pageReplacement == "CL")
+            if (!allocate)
+                return NULL;
+            RadixLeaf *fresh = new RadixLeaf();
+            if (middle.compare_exchange_strong(leaf, fresh, memory_order_acq_rel))
             {
-
-                frameNumber = applyClockReplacement(pageTable, physicalMemory, fd, globalFrameSize, virtual_page_number, clockHand);
-                // increase the number of page replacements
-                statsOfProgram.pageReplacements++;
-                // increase the number of page misses
-                statsOfProgram.pageMisses++;
+                leaf = fresh;
+                leafCount++;
             }
-
-            // increase the number of disk page reads
-            statsOfProgram.diskPageReads++;
-            lseek(fd, pageIndex * globalFrameSize * sizeof(int), SEEK_SET);
-            read(fd, &physicalMemory[frameNumber * globalFrameSize], globalFrameSize * sizeof(int));
-
-            pageTable[pageIndex].frameNumber = frameNumber;
-            pageTable[pageIndex].valid = 1;
-            pageTable[pageIndex].modified = 1;
-            pageTable[pageIndex].referenced = 1;
-            pageTable[pageIndex].lastAccessTime = time_in_us;
-
-            physicalMemory[frameNumber * globalFrameSize + offset].data = value;
-            physicalMemory[frameNumber * globalFrameSize + offset].threadNum = threadNum;
-
-            // update the thread number and disk index
-            for (uint32_t j = 0; j < globalFrameSize; ++j)
+            else
             {
-                physicalMemory[frameNumber * globalFrameSize + j].diskIndex = pageIndex * globalFrameSize + j;
+                delete fresh;
             }
         }
+        return leaf;
     }
 
-    // print the page table at every pageTablePrintInt memory accesses
-    memoryAccessCounter++;
-    if (memoryAccessCounter % pageTablePrintInt == 0)
+    // node of a page in the inverted table, -1 if it has none. the caller holds the page lock
+    inline int nodeOf(int pageIndex) const
     {
-        printPageTable();
+        int node = buckets[bucketOf(pageIndex)];
+        while (node != -1 && nodes[node].pageIndex != pageIndex)
+            node = nodes[node].next;
+        return node;
     }
-}
-
-int get(unsigned int threadNum, unsigned int index)
-{
-    // increase the read counter
-    statsOfProgram.reads++;
-
-    int pageIndex = index / globalFrameSize; // calculate the page index
-    int offset = index % globalFrameSize;    // calculate the offset in the page
-
-    // current time in microseconds
-    auto now = std::chrono::steady_clock::now();
-    auto now_us = std::chrono::time_point_cast<std::chrono::microseconds>(now);
-    long long time_in_us = now_us.time_since_epoch().count();
 
-    if (pageTable[pageIndex].valid)
-    {
-        // page is in the physical memory
-        int frameNumber = pageTable[pageIndex].frameNumber;
-
-        // update the page table entry
-        pageTable[pageIndex].referenced = 1;
-        pageTable[pageIndex].lastAccessTime = time_in_us;
-
-        // return the value in the physical memory
-        return physicalMemory[frameNumber * globalFrameSize + offset].data;
-    }
-    else
+    // entry of a page, the empty entry if the page has none. the caller holds the page lock
+    inline PageTableEntry &operator[](int pageIndex)
     {
-        // page is not in the physical memory. Page fault occurs
-        int frameNumber = -1;
-
-        // find an empty frame in the physical memory
-        for (uint32_t i = 0; i < physical_memory_size / globalFrameSize; i++)
+        if (mode == PAGE_TABLE_FLAT)
+            return flat[pageIndex];
+        if (mode == PAGE_TABLE_RADIX)
         {
-            bool frameEmpty = true;
-            for (uint32_t j = 0; j < globalFrameSize; j++)
-            {
-                if (physicalMemory[i * globalFrameSize + j].threadNum != -1)
-                {
-                    frameEmpty = false;
-                    break;
-                }
-            }
-            if (frameEmpty)
-            {
-                frameNumber = i;
-                break;
-            }
+            RadixLeaf *leaf = leafOf(pageIndex, false);
+            return leaf ? leaf->entries[pageIndex & ((1 << RADIX_LEAF_BITS) - 1)] : empty;
         }
+        int node = nodeOf(pageIndex);
+        return node != -1 ? nodes[node].entry : empty;
+    }
+
+    // entry of a page that is about to go in transit, made if the page has none. the caller holds the page lock
+    PageTableEntry &create(int pageIndex)
+    {
+        if (mode == PAGE_TABLE_FLAT)
+            return flat[pageIndex];
+        if (mode == PAGE_TABLE_RADIX)
+            return leafOf(pageIndex, true)->entries[pageIndex & ((1 << RADIX_LEAF_BITS) - 1)];
 
-        if (frameNumber == -1)
+        int node = nodeOf(pageIndex);
+        if (node != -1)
+            return nodes[node].entry;
         {
-            // no empty frame in the physical memory. Page replacement is needed
-            if (pageReplacement == "LRU")
+            lock_guard<mutex> freeGuard(freeMutex);
+            node = freeNode;
+            if (node == -1)
             {
-                frameNumber = applyLRUReplacement(pageTable, physicalMemory, fd, globalFrameSize, virtual_page_number);
-                // increase the number of page replacements
-                statsOfProgram.pageReplacements++;
-                // increase the number of page misses
-                statsOfProgram.pageMisses++;
-            }
-            else if (pageReplacement == "CL")
-            {
-                frameNumber = applyClockReplacement(pageTable, physicalMemory, fd, globalFrameSize, virtual_page_number, clockHand);
-                // increase the number of page replacements
-                statsOfProgram.pageReplacements++;
-                // increase the number of page misses
-                statsOfProgram.pageMisses++;
+                // every resident page and every page in transit has a node, so this does not happen
+                cout << "Error: the inverted page table is full" << endl;
+                exit(1);
             }
+            freeNode = nodes[node].next;
         }
+        int bucket = bucketOf(pageIndex);
+        nodes[node].entry.store(PTE_FRAME_MASK);
+        nodes[node].pageIndex = pageIndex;
+        nodes[node].next = buckets[bucket];
+        buckets[bucket] = node;
+        return nodes[node].entry;
+    }
 
-        // read the page from the disk to the physical memory
-        // increase the number of disk page reads
-        statsOfProgram.diskPageReads++;
-        lseek(fd, pageIndex * globalFrameSize * sizeof(int), SEEK_SET);
-        read(fd, &physicalMemory[frameNumber * globalFrameSize], globalFrameSize * sizeof(int));
-
-        // update the page table entry
-        pageTable[pageIndex].frameNumber = frameNumber;
-        pageTable[pageIndex].valid = 1;
-        pageTable[pageIndex].referenced = 1;
-        pageTable[pageIndex].lastAccessTime = time_in_us;
-
-        // update the thread number and disk index
-        for (uint32_t j = 0; j < globalFrameSize; j++)
-        {
-            physicalMemory[frameNumber * globalFrameSize + j].threadNum = threadNum;
-            physicalMemory[frameNumber * globalFrameSize + j].diskIndex = pageIndex * globalFrameSize + j;
-        }
+    // the inverted table drops the entry of a page that is not resident, in transit or being written back.
+    // the caller holds the page lock
+    void release(int pageIndex)
+    {
+        if (mode != PAGE_TABLE_INVERTED)
+            return;
+        int *link = &buckets[bucketOf(pageIndex)];
+        while (*link != -1 && nodes[*link].pageIndex != pageIndex)
+            link = &nodes[*link].next;
+        int node = *link;
+        if (node == -1 || (nodes[node].entry.load() & (PTE_VALID | PTE_IN_TRANSIT | PTE_WRITEBACK)))
+            return;
+        *link = nodes[node].next;
+        nodes[node].pageIndex = -1;
+        lock_guard<mutex> freeGuard(freeMutex);
+        nodes[node].next = freeNode;
+        freeNode = node;
+    }
 
-        // print the page table at every pageTablePrintInt memory accesses
-        memoryAccessCounter++;
-        if (memoryAccessCounter % pageTablePrintInt == 0)
+    // bytes that the page table takes
+    size_t bytes() const
+    {
+        if (mode == PAGE_TABLE_FLAT)
+            return (size_t)size * sizeof(PageTableEntry);
+        if (mode == PAGE_TABLE_RADIX)
         {
-            printPageTable();
+            size_t middles = 0;
+            for (int d = 0; d < directoryCount; d++)
+                middles += directories[d].load(memory_order_relaxed) != NULL;
+            return directoryCount * sizeof(atomic<RadixDirectory *>) + middles * sizeof(RadixDirectory) + leafCount * sizeof(RadixLeaf);
         }
-
-        // return the value in the physical memory
-        return physicalMemory[frameNumber * globalFrameSize + offset].data;
+        return (size_t)capacity * sizeof(InvertedNode) + buckets.size() * sizeof(int);
     }
-}
-
-void merge(unsigned int threadNum, int left, int mid, int right)
-{
-    int n1 = mid - left + 1;
-    int n2 = right - mid;
-
-    // create temporary arrays
-    std::vector<int> L(n1);
-    std::vector<int> R(n2);
+};
 
-    // Copy data to temporary arrays L[] and R[]
-    for (int i = 0; i < n1; i++)
-        L[i] = get(threadNum, left + i);
-    for (int j = 0; j < n2; j++)
-        R[j] = get(threadNum, mid + 1 + j);
+PageTable pageTable; // page table of the current simulation
 
-    // Merge the temporary arrays back into arr[left..right]
-    int i = 0, j = 0;
-    int k = left;
+// intrusive doubly-linked lists over the pages, indexed by page number. a page is in at most one of the lists.
+// the head of a list is its most recently inserted page and the tail its oldest one, so a policy finds its
+// victim at the tail in O(1) and a hit only moves one node to the head.
+struct PageLists
+{
+    vector<int> prev;          // previous (newer) page in the list, -1 for the head
+    vector<int> next;          // next (older) page in the list, -1 for the tail
+    vector<signed char> owner; // list that holds the page, -1 for none
+    int head[MAX_PAGE_LISTS];
+    int tail[MAX_PAGE_LISTS];
+    int size[MAX_PAGE_LISTS];
 
-    while (i < n1 && j < n2)
+    void init(int pageCount)
     {
-        if (L[i] <= R[j])
+        prev.assign(pageCount, -1);
+        next.assign(pageCount, -1);
+        owner.assign(pageCount, -1);
+        for (int list = 0; list < MAX_PAGE_LISTS; list++)
         {
-            set(threadNum, k, L[i]);
-            i++;
-        }
-        else
-        {
-            set(threadNum, k, R[j]);
-            j++;
+            head[list] = -1;
+            tail[list] = -1;
+            size[list] = 0;
         }
-        k++;
     }
 
-    // Copy the remaining elements of L[], if there are any
-    while (i < n1)
+    void pushFront(int list, int page)
     {
-        set(threadNum, k, L[i]);
-        i++;
-        k++;
+        prev[page] = -1;
+        next[page] = head[list];
+        if (head[list] != -1)
+            prev[head[list]] = page;
+        head[list] = page;
+        if (tail[list] == -1)
+            tail[list] = page;
+        owner[page] = list;
+        size[list]++;
     }
 
-    while (j < n2)
+    // remove a page from its list. nothing happens if it is in no list
+    void unlink(int page)
     {
-        set(threadNum, k, R[j]);
-        j++;
-        k++;
+        int list = owner[page];
+        if (list == -1)
+            return;
+        if (prev[page] != -1)
+            next[prev[page]] = next[page];
+        else
+            head[list] = next[page];
+        if (next[page] != -1)
+            prev[next[page]] = prev[page];
+        else
+            tail[list] = prev[page];
+        prev[page] = -1;
+        next[page] = -1;
+        owner[page] = -1;
+        size[list]--;
     }
-}
 
-void mergeSort(unsigned int threadNum, int left, int right)
-{
-    if (left < right)
+    void moveToFront(int list, int page)
     {
-        int mid = left + (right - left) / 2;
+        if (head[list] == page)
+            return;
+        unlink(page);
+        pushFront(list, page);
+    }
+};
 
-        // sort the left half
-        mergeSort(threadNum, left, mid);
+// page replacement policy. the pager calls it with the pager lock held:
+//   onMiss       a fault on a page that is not resident, before a frame is taken for it
+//   onInsert     the page is mapped into a frame, by a fault or a readahead
+//   onHit        an access of a resident page. only called if tracksHits, the Clock-like policies read the
+//                referenced bit instead. in the concurrent mode the hits come late, in batches (see HitBuffer)
+//   onEvict      the page is unmapped, by an eviction or a release
+//   selectVictim the resident page to evict, -1 if no page can be evicted now
+struct ReplacementPolicy
+{
+    bool tracksHits;
+    unsigned int owner; // 0 if the policy replaces the pages of every process, else the only process it replaces for
 
-        // sort the right half
-        mergeSort(threadNum, mid + 1, right);
+    ReplacementPolicy(bool hits) : tracksHits(hits), owner(0) {}
+    bool owns(int pageIndex) const { return owner == 0 || (unsigned int)(pageIndex / process_page_number) + 1 == owner; }
+    virtual ~ReplacementPolicy() {}
+    virtual void onMiss(int /*pageIndex*/) {}
+    virtual void onInsert(int /*pageIndex*/) {}
+    virtual void onHit(int /*pageIndex*/) {}
+    virtual void onEvict(int /*pageIndex*/) {}
+    virtual int selectVictim() = 0;
+};
 
-        // merge the sorted halves
-        merge(threadNum, left, mid, right);
-    }
+// how the frames are divided between the processes, selected with allocation=global|fixed|pff|ws
+enum FrameAllocation
+{
+    ALLOCATION_GLOBAL, // one replacement policy over the pages of every process
+    ALLOCATION_FIXED,  // local replacement, every process has the same share of the frames
+    ALLOCATION_PFF,    // local replacement, quotas from the page fault frequency of the processes
+    ALLOCATION_WS      // local replacement, quotas from the working sets of the processes
+};
+FrameAllocation frameAllocation = ALLOCATION_GLOBAL;
+const char *allocationNames[] = {"global", "fixed", "pff", "ws"}; // option values, in the order of FrameAllocation
+
+ReplacementPolicy *policy = NULL;                    // replacement policy of the simulation
+ReplacementPolicy *processPolicies[MAX_THREADS + 1]; // policy of every process under local replacement
+
+// policy that replaces a page
+inline ReplacementPolicy *policyOf(int pageIndex)
+{
+    return (frameAllocation == ALLOCATION_GLOBAL) ? policy : processPolicies[pageIndex / process_page_number + 1];
 }
 
-void initializeDisk()
+// sequential stream detection of one process. a fault on expectedPage continues the stream and reads the
+// next window pages ahead. the window doubles while the read ahead pages are used and halves when one of
+// them is evicted without an access. only the owner process changes it, except wastedPages
+struct alignas(64) ReadaheadState
 {
-    // disk is a file. you can use file operations to initialize the disk.
-    // open the file and write random integers to the file.
+    int expectedPage;                 // page after the last page that was read, -1 at the start
+    int window;                       // pages to read ahead, 0 before the first readahead
+    atomic<unsigned int> wastedPages; // read ahead pages of the process that were evicted without an access
+    unsigned int wastedSeen;          // wastedPages at the last readahead
+};
 
-    fd = open(disk_file_name.c_str(), O_RDWR | O_CREAT, 0666);
-    if (fd == -1)
-    {
-        cout << "Error: Cannot open disk file" << endl;
-        exit(1);
-    }
+ReadaheadState readaheadStates[MAX_THREADS + 1]; // readahead state of every process, indexed by thread number
 
-    // fill the -1 to the disk for the first time
-    int randomInt = -1;
-    for (int i = 0; i < disk_size; i++)
+// forget the streams of a previous simulation
+void initializeReadahead()
+{
+    for (int t = 0; t <= MAX_THREADS; t++)
     {
-        write(fd, &randomInt, sizeof(int));
+        readaheadStates[t].expectedPage = -1;
+        readaheadStates[t].window = 0;
+        readaheadStates[t].wastedPages = 0;
+        readaheadStates[t].wastedSeen = 0;
     }
+    // at most a quarter of the frames of a process are read ahead at once
+    readaheadMaxPages = min(READAHEAD_MAX_PAGES, physical_frame_number / (4 * numThreads));
 }
 
-void printDisk()
+void printStatistics(const Statistics &stats)
 {
-    // print disk entries
-    int randomInt;
-    lseek(fd, 0, SEEK_SET);
-    for (int i = 0; i < disk_size; i++)
+    // print the statistics in a table format
+    printf("┌───────────────────────────────┬────────────┐\n");
+    printf("│ Statistic                     │ Value      │\n");
+    printf("├───────────────────────────────┼────────────┤\n");
+    printf("│ Reads                         │ %10u │\n", stats.reads);
+    printf("│ Writes                        │ %10u │\n", stats.writes);
+    printf("│ Page Misses                   │ %10u │\n", stats.pageMisses);
+    printf("│ Page Replacements             │ %10u │\n", stats.pageReplacements);
+    printf("│ Disk Page Writes              │ %10u │\n", stats.diskPageWrites);
+    printf("│ Disk Page Reads               │ %10u │\n", stats.diskPageReads);
+    printf("│ First Touch Pages             │ %10u │\n", stats.firstTouchPages);
+    printf("│ Physical Frames In Memory     │ %10u │\n", stats.physicalFramesInMemory);
+    printf("│ TLB Hits                      │ %10u │\n", stats.tlbHits);
+    printf("│ TLB Misses                    │ %10u │\n", stats.tlbMisses);
+    if (backgroundWriteback)
+        printf("│ Background Page Writes        │ %10u │\n", stats.backgroundPageWrites);
+    if (readaheadEnabled)
     {
-        read(fd, &randomInt, sizeof(int));
-
-        printf("Disk Entry %3d: %10d\n", i, randomInt);
+        printf("│ Prefetched Pages              │ %10u │\n", stats.prefetchedPages);
+        printf("│ Prefetch Hits                 │ %10u │\n", stats.prefetchHits);
+        printf("│ Wasted Prefetches             │ %10u │\n", stats.wastedPrefetches);
+    }
+    if (pageoutClusterPages > 1)
+    {
+        printf("│ Disk Write Operations         │ %10u │\n", stats.diskWriteOperations);
+        printf("│ Pages Per Disk Write          │ %10.2f │\n", stats.diskWriteOperations ? (double)stats.diskPageWrites / stats.diskWriteOperations : 0.0);
+    }
+    if (asyncFaultIO)
+    {
+        printf("│ Async Page-Ins                │ %10u │\n", stats.asyncPageIns);
+        printf("│ Parked Page-Ins               │ %10u │\n", stats.parkedPageIns);
+    }
+    if (zswapPoolPages > 0)
+    {
+        printf("│ Zswap Stores                  │ %10u │\n", stats.zswapStores);
+        printf("│ Zswap Loads                   │ %10u │\n", stats.zswapLoads);
+        printf("│ Zswap Writebacks              │ %10u │\n", stats.zswapWritebacks);
+        printf("│ Zswap Rejects                 │ %10u │\n", stats.zswapRejects);
+        printf("│ Compression Ratio             │ %10.2f │\n", stats.zswapCompressedBytes ? (double)stats.zswapStoredBytes / stats.zswapCompressedBytes : 0.0);
+        // every load is a disk read and every store that stays in the pool a disk write that did not happen
+        printf("│ Disk I/Os Avoided             │ %10u │\n", stats.zswapLoads + stats.zswapStores - stats.zswapWritebacks);
     }
+    printf("└───────────────────────────────┴────────────┘\n");
 }
 
-int binarySearch(int threadNum, int l, int r, int x)
+// physical frame metadata, one entry per frame
+struct FrameInfo
 {
-    while (l <= r)
-    {
-        int m = l + (r - l) / 2;
+    int threadNum; // thread number that owns the frame, -1 if the frame is free
+    int pageIndex; // virtual page that is mapped into the frame, -1 if the frame is free
+    int diskIndex; // index of the first integer of the page in the disk, -1 if the page has not been on the disk yet
+};
 
-        int mid = get(threadNum, m); // get the value of the data at the given index in the virtual memory
+vector<FrameInfo> frameTable; // ownership of every physical frame
+vector<int> freeFrames;       // stack of free frame numbers. the lowest free frame is on top
 
-        if (mid == x)
+int framesHeld[MAX_THREADS + 1];  // frames of every process, the ones reserved for its faults too. protected by pagerMutex
+int frameQuota[MAX_THREADS + 1];  // frames every process should hold under local replacement. protected by pagerMutex
+vector<unsigned char> frameHistory; // ws: referenced bits of the page of every frame in the last two samples
+
+// call visit(pageIndex, entry) for the entries of the page table: every entry of the flat table, the entries of
+// the resident pages in the order of their frames for a sparse table. other processes keep running, the pager
+// lock is held so no page is mapped or evicted meanwhile
+template <class Visit>
+void visitPageTable(Visit visit)
+{
+    unique_lock<mutex> pagerGuard(pagerMutex, defer_lock);
+    if (concurrentMode)
+        pagerGuard.lock();
+
+    int entryCount = (pageTable.mode == PAGE_TABLE_FLAT) ? page_table_size : physical_frame_number;
+    for (int e = 0; e < entryCount; e++)
+    {
+        int i = (pageTable.mode == PAGE_TABLE_FLAT) ? e : frameTable[e].pageIndex;
+        if (i == -1)
+            continue;
+        unique_lock<mutex> pageGuard(pageLockOf(i).lock, defer_lock);
+        if (concurrentMode && pageTable.mode != PAGE_TABLE_FLAT)
+            pageGuard.lock();
+        if (pageTable.mode != PAGE_TABLE_FLAT && pageTable[i].frameNumber() != e)
+            continue;
+        visit(i, pageTable[i]);
+    }
+}
+
+// page table print function
+void printPageTable()
+{
+    // print the page table entries
+    printf("┌──────────────┬──────────────┬────────┬─────────┬───────────┬────────────────────┐\n");
+    printf("│ Page Table   │ Frame Number │ Valid  │ Modified│ Referenced│ Last Access Time   │\n");
+    printf("├──────────────┼──────────────┼────────┼─────────┼───────────┼────────────────────┤\n");
+
+    // print the page table entries for each page
+    visitPageTable([](int i, const PageTableEntry &entry) {
+        printf("│ Entry %2d     │ %12d │ %6d │ %8d │ %9d │ %18ld │\n",
+               i,
+               entry.frameNumber(),
+               entry.valid(),
+               entry.modified(),
+               entry.referenced(),
+               static_cast<long>(entry.lastAccessTime()));
+    });
+
+    // print the end of the page table
+    printf("└──────────────┴──────────────┴────────┴─────────┴───────────┴────────────────────┘\n");
+}
+
+// initialize the page table for the virtual pages of all processes. every entry has no frame, so it is not in
+// physical memory, and every bit 0. the inverted table has a node for every frame and for the pages that can be
+// in transit at once: a fault, its read ahead pages and their dirty victims for every process
+void initializePageTable()
+{
+    pageTable.init(pageTableMode, page_table_size, physical_frame_number + numThreads * 2 * (READAHEAD_MAX_PAGES + 1));
+}
+
+// physical memory. frame f holds the integers [f * globalFrameSize, (f + 1) * globalFrameSize),
+// so a whole page is moved to or from the disk with a single read or write
+vector<int> physicalMemory;
+
+void initializePhysicalMemory()
+{
+    // every entry of the physical memory starts empty
+    physicalMemory.assign(physical_memory_size, -1);
+
+    // every frame starts free. push them in reverse order so frame 0 is allocated first
+    frameTable.assign(physical_frame_number, {-1, -1, -1});
+    frameHistory.assign(physical_frame_number, 0);
+    fill(framesHeld, framesHeld + MAX_THREADS + 1, 0);
+    freeFrames.clear();
+    for (int i = physical_frame_number - 1; i >= 0; i--)
+    {
+        freeFrames.push_back(i);
+    }
+}
+
+// take a free frame from the free frame stack. returns -1 if all frames are in use
+int allocateFrame()
+{
+    if (freeFrames.empty())
+        return -1;
+
+    int frameNumber = freeFrames.back();
+    freeFrames.pop_back();
+    return frameNumber;
+}
+
+// give a frame back to the free frame stack. the caller holds the pager lock
+void releaseFrame(int frameNumber)
+{
+    if (frameTable[frameNumber].threadNum > 0)
+        framesHeld[frameTable[frameNumber].threadNum]--;
+    frameTable[frameNumber].threadNum = -1;
+    frameTable[frameNumber].pageIndex = -1;
+    frameTable[frameNumber].diskIndex = -1;
+    freeFrames.push_back(frameNumber);
+}
+
+// give a frame to a page of a process. the frame is free or was taken from an evicted page of any process. the
+// page is in transit, it is mapped later. the caller holds the pager lock
+void assignFrame(int frameNumber, unsigned int threadNum, int pageIndex)
+{
+    if (frameTable[frameNumber].threadNum > 0)
+        framesHeld[frameTable[frameNumber].threadNum]--;
+    framesHeld[threadNum]++;
+    frameTable[frameNumber].threadNum = threadNum;
+    frameTable[frameNumber].pageIndex = pageIndex;
+    frameTable[frameNumber].diskIndex = -1;
+    frameHistory[frameNumber] = 0;
+}
+
+// compressed swap pool (zswap). a modified victim is compressed into a bounded pool in the memory instead of
+// being written to the disk, and a fault on it decompresses it without a disk read. the pool keeps its copy
+// while the page is resident and clean; a later eviction of the modified page replaces the copy, and a disk
+// write of the page drops it. when the pool is full its least recently stored pages are written to the disk.
+// zswapMutex is a leaf lock, the disk writes of the pool are done under it so no fault reads the disk slot of a
+// page before its write
+struct ZswapEntry
+{
+    vector<unsigned char> data;     // compressed page
+    list<int>::iterator position;   // place of the page in zswapOrder
+};
+unordered_map<int, ZswapEntry> zswapPool; // compressed pages by page index
+list<int> zswapOrder;                     // pages of the pool, the least recently stored first
+size_t zswapPoolBytes = 0;                // compressed bytes in the pool
+mutex zswapMutex;                         // protects the pool
+
+// empty the pool of a previous simulation
+void initializeZswap()
+{
+    zswapPool.clear();
+    zswapOrder.clear();
+    zswapPoolBytes = 0;
+}
+
+// append a varint, 7 bits per byte, the low bits first. returns false if it does not fit before end
+inline bool putVarint(unsigned char *&out, const unsigned char *end, unsigned long long value)
+{
+    do
+    {
+        if (out == end)
+            return false;
+        unsigned char byte = value & 0x7F;
+        value >>= 7;
+        *out++ = byte | (value ? 0x80 : 0);
+    } while (value);
+    return true;
+}
+
+inline unsigned long long getVarint(const unsigned char *&in)
+{
+    unsigned long long value = 0;
+    for (int shift = 0;; shift += 7)
+    {
+        unsigned char byte = *in++;
+        value |= (unsigned long long)(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+            return value;
+    }
+}
+
+// compress a page: the difference of every integer to the one before it as a zigzag varint, a run of equal
+// integers as a 0 byte and the length of the run. random integers below 1000 take two bytes, a sorted page
+// mostly runs. returns the compressed size, or 0 if the page does not get smaller
+int compressPage(const int *page, unsigned char *out)
+{
+    unsigned char *begin = out;
+    const unsigned char *end = out + globalFrameSize * sizeof(int) - 1;
+    long long previous = 0;
+    for (int i = 0; i < globalFrameSize;)
+    {
+        long long difference = (long long)page[i] - previous;
+        if (difference == 0)
+        {
+            int run = 1;
+            while (i + run < globalFrameSize && page[i + run] == page[i])
+                run++;
+            if (out == end || (*out++ = 0, !putVarint(out, end, run)))
+                return 0;
+            i += run;
+            continue;
+        }
+        // a varint of a value above 0 never starts with a 0 byte
+        if (!putVarint(out, end, ((unsigned long long)difference << 1) ^ (unsigned long long)(difference >> 63)))
+            return 0;
+        previous = page[i];
+        i++;
+    }
+    return out - begin;
+}
+
+void decompressPage(const unsigned char *in, int *page)
+{
+    long long previous = 0;
+    for (int i = 0; i < globalFrameSize;)
+    {
+        if (*in == 0)
+        {
+            in++;
+            int run = getVarint(in);
+            fill(page + i, page + i + run, (int)previous);
+            i += run;
+            continue;
+        }
+        unsigned long long zigzag = getVarint(in);
+        previous += (long long)(zigzag >> 1) ^ -(long long)(zigzag & 1);
+        page[i++] = (int)previous;
+    }
+}
+
+// write the least recently stored page of the pool to the disk and drop it from the pool. returns the page.
+// the caller holds zswapMutex
+int zswapWritebackOldest(vector<int> &page)
+{
+    int oldest = zswapOrder.front();
+    ZswapEntry &entry = zswapPool[oldest];
+    size_t pageBytes = globalFrameSize * sizeof(int);
+    decompressPage(&entry.data[0], &page[0]);
+    if (mmapDisk)
+        memcpy(&diskMapping[(size_t)oldest * globalFrameSize], &page[0], pageBytes);
+    else
+        pwrite(fd, &page[0], pageBytes, (off_t)oldest * pageBytes);
+    diskPageWritten[oldest].store(1, memory_order_relaxed);
+    zswapPoolBytes -= entry.data.size();
+    zswapOrder.pop_front();
+    zswapPool.erase(oldest);
+    return oldest;
+}
+
+// final flush of the pool, the disk gets every page of it. the processes are done
+void zswapFlush()
+{
+    lock_guard<mutex> zswapGuard(zswapMutex);
+    vector<int> page(globalFrameSize);
+    while (!zswapOrder.empty())
+    {
+        int pageIndex = zswapWritebackOldest(page);
+        backgroundPageWrites[pageIndex / process_page_number + 1].fetch_add(1, memory_order_relaxed);
+    }
+}
+
+// drop the pool copy of a page that is written to the disk
+inline void zswapInvalidate(int pageIndex)
+{
+    if (zswapPoolPages == 0)
+        return;
+    lock_guard<mutex> zswapGuard(zswapMutex);
+    unordered_map<int, ZswapEntry>::iterator it = zswapPool.find(pageIndex);
+    if (it == zswapPool.end())
+        return;
+    zswapPoolBytes -= it->second.data.size();
+    zswapOrder.erase(it->second.position);
+    zswapPool.erase(it);
+}
+
+// compress a modified victim into the pool. the page is in transit. returns false if the pool is off or the page
+// does not get smaller, the caller writes it to the disk then
+bool zswapStore(unsigned int threadNum, int pageIndex, const int *frame)
+{
+    if (zswapPoolPages == 0)
+        return false;
+    Statistics &stats = threadStats[threadNum].stats;
+    size_t pageBytes = globalFrameSize * sizeof(int);
+    size_t capacity = (size_t)zswapPoolPages * pageBytes;
+    vector<unsigned char> compressed(pageBytes);
+    int size = compressPage(frame, &compressed[0]);
+    if (size == 0)
+    {
+        stats.zswapRejects++;
+        return false;
+    }
+    compressed.resize(size);
+
+    lock_guard<mutex> zswapGuard(zswapMutex);
+    unordered_map<int, ZswapEntry>::iterator it = zswapPool.find(pageIndex);
+    if (it != zswapPool.end())
+    {
+        zswapPoolBytes -= it->second.data.size();
+        zswapOrder.erase(it->second.position);
+        zswapPool.erase(it);
+    }
+
+    // make room: the least recently stored pages go to the disk
+    vector<int> page(globalFrameSize);
+    while (zswapPoolBytes + size > capacity && !zswapOrder.empty())
+    {
+        zswapWritebackOldest(page);
+        stats.diskPageWrites++;
+        stats.diskWriteOperations++;
+        stats.zswapWritebacks++;
+    }
+
+    ZswapEntry &entry = zswapPool[pageIndex];
+    entry.data.swap(compressed);
+    entry.position = zswapOrder.insert(zswapOrder.end(), pageIndex);
+    zswapPoolBytes += size;
+    stats.zswapStores++;
+    stats.zswapStoredBytes += pageBytes;
+    stats.zswapCompressedBytes += size;
+    return true;
+}
+
+// decompress a page of the pool into its frame. returns false if the page is not in the pool
+bool zswapLoad(unsigned int threadNum, int pageIndex, int *frame)
+{
+    if (zswapPoolPages == 0)
+        return false;
+    lock_guard<mutex> zswapGuard(zswapMutex);
+    unordered_map<int, ZswapEntry>::iterator it = zswapPool.find(pageIndex);
+    if (it == zswapPool.end())
+        return false;
+    decompressPage(&it->second.data[0], frame);
+    threadStats[threadNum].stats.zswapLoads++;
+    return true;
+}
+
+// true if the pool has a copy of a page, which is newer than its disk slot
+bool zswapContains(int pageIndex)
+{
+    if (zswapPoolPages == 0)
+        return false;
+    lock_guard<mutex> zswapGuard(zswapMutex);
+    return zswapPool.count(pageIndex) != 0;
+}
+
+// read a run of consecutive pages from the disk file, with the latency of disklatency=N
+void readDiskRun(struct iovec *frames, int count, off_t offset)
+{
+    if (diskReadLatencyUs > 0)
+        this_thread::sleep_for(chrono::microseconds(diskReadLatencyUs));
+    preadv(fd, frames, count, offset);
+}
+
+// read count consecutive pages that start at firstPage into their frames. a page that was never written to the
+// disk has no data in its slot: its frame gets the initial content of the disk, -1 in every integer, without a
+// disk read. every run of written pages is read with one preadv, which keeps the file offset out of the way of
+// the other processes
+void readPagesFromDisk(unsigned int threadNum, int firstPage, const int *frameNumbers, int count)
+{
+    Statistics &stats = threadStats[threadNum].stats;
+    struct iovec frames[READAHEAD_MAX_PAGES + 1];
+    int runStart = 0; // first page of the current run of written pages
+    for (int i = 0; i <= count; i++)
+    {
+        if (i < count)
+        {
+            int *frame = &physicalMemory[frameNumbers[i] * globalFrameSize];
+            frameTable[frameNumbers[i]].diskIndex = (firstPage + i) * globalFrameSize;
+            // a page of the zswap pool ends the run of disk reads like a page that was never written
+            bool inPool = zswapLoad(threadNum, firstPage + i, frame);
+            if (!inPool && diskPageWritten[firstPage + i].load(memory_order_relaxed))
+            {
+                frames[i].iov_base = frame;
+                frames[i].iov_len = globalFrameSize * sizeof(int);
+                if (mmapDisk)
+                    memcpy(frame, &diskMapping[(size_t)(firstPage + i) * globalFrameSize], frames[i].iov_len);
+                continue;
+            }
+            if (!inPool)
+            {
+                fill(frame, frame + globalFrameSize, -1);
+                stats.firstTouchPages++;
+            }
+        }
+
+        // pages runStart to i - 1 are written
+        if (i > runStart)
+        {
+            stats.diskPageReads += i - runStart;
+            if (!mmapDisk)
+                readDiskRun(&frames[runStart], i - runStart, (off_t)(firstPage + runStart) * globalFrameSize * sizeof(int));
+        }
+        runStart = i + 1;
+    }
+}
+
+// write a whole frame to the disk slot of a page
+void writePageToDisk(unsigned int threadNum, int pageIndex, int frameNumber)
+{
+    // increase the number of disk page writes
+    threadStats[threadNum].stats.diskPageWrites++;
+    threadStats[threadNum].stats.diskWriteOperations++;
+    diskPageWritten[pageIndex].store(1, memory_order_relaxed);
+    zswapInvalidate(pageIndex);
+    if (mmapDisk)
+        memcpy(&diskMapping[(size_t)pageIndex * globalFrameSize], &physicalMemory[frameNumber * globalFrameSize], globalFrameSize * sizeof(int));
+    else
+        pwrite(fd, &physicalMemory[frameNumber * globalFrameSize], globalFrameSize * sizeof(int), (off_t)pageIndex * globalFrameSize * sizeof(int));
+}
+
+// clustered page-out. a dirty victim is written together with the dirty resident pages around it, whose disk
+// slots are next to its slot, in one pwritev. the neighbours are copied and marked clean under their locks like
+// in flushPage, and stay resident in writeback until the write is done
+struct PageoutCluster
+{
+    int firstPage;      // page of the first disk slot of the cluster
+    int count;          // pages in the cluster, the victim included
+    int victimPage;     // evicted page, written from its frame
+    int victimFrame;    // frame of the evicted page
+    vector<int> copies; // copies of the neighbours: the ones before the victim from the nearest one back, then the ones after it
+};
+
+// put the dirty neighbours of a dirty victim in its cluster, up to pageoutClusterPages pages in the pages of the
+// same process. the caller holds the pager lock
+void gatherPageoutCluster(int victimPage, int victimFrame, PageoutCluster &cluster)
+{
+    cluster.firstPage = victimPage;
+    cluster.count = 1;
+    cluster.victimPage = victimPage;
+    cluster.victimFrame = victimFrame;
+    cluster.copies.clear();
+    // the victim goes to the zswap pool on its own
+    if (zswapPoolPages > 0)
+        return;
+
+    int processFirstPage = victimPage / process_page_number * process_page_number;
+    int processEndPage = processFirstPage + process_page_number;
+    for (int direction = -1; direction <= 1; direction += 2)
+    {
+        for (int page = victimPage + direction; page >= processFirstPage && page < processEndPage && cluster.count < pageoutClusterPages; page += direction)
+        {
+            unique_lock<mutex> pageGuard(pageLockOf(page).lock, defer_lock);
+            if (concurrentMode)
+                pageGuard.lock();
+            if (!pageTable[page].valid() || !pageTable[page].modified() || pageTable[page].writeback())
+                break;
+            const int *data = &physicalMemory[pageTable[page].frameNumber() * globalFrameSize];
+            cluster.copies.insert(cluster.copies.end(), data, data + globalFrameSize);
+            pageTable[page].setModified(0);
+            pageTable[page].setWriteback(1);
+            tlbClearDirty(page);
+            cluster.count++;
+            if (direction == -1)
+                cluster.firstPage = page;
+        }
+    }
+}
+
+// write a cluster with one pwritev and end the writeback of its neighbours. the caller holds no lock
+void writePageoutCluster(unsigned int threadNum, PageoutCluster &cluster)
+{
+    if (cluster.count == 1 && zswapStore(threadNum, cluster.victimPage, &physicalMemory[cluster.victimFrame * globalFrameSize]))
+        return;
+    if (cluster.count == 1)
+    {
+        writePageToDisk(threadNum, cluster.victimPage, cluster.victimFrame);
+        return;
+    }
+
+    struct iovec pages[PAGEOUT_CLUSTER_MAX];
+    int before = cluster.victimPage - cluster.firstPage; // neighbours before the victim
+    for (int i = 0; i < cluster.count; i++)
+    {
+        int page = cluster.firstPage + i;
+        int *data;
+        if (page == cluster.victimPage)
+            data = &physicalMemory[cluster.victimFrame * globalFrameSize];
+        else if (page < cluster.victimPage)
+            data = &cluster.copies[(size_t)(cluster.victimPage - 1 - page) * globalFrameSize];
+        else
+            data = &cluster.copies[(size_t)(before + page - cluster.victimPage - 1) * globalFrameSize];
+        pages[i].iov_base = data;
+        pages[i].iov_len = globalFrameSize * sizeof(int);
+        diskPageWritten[page].store(1, memory_order_relaxed);
+        zswapInvalidate(page);
+        if (mmapDisk)
+            memcpy(&diskMapping[(size_t)page * globalFrameSize], data, pages[i].iov_len);
+    }
+    if (!mmapDisk)
+        pwritev(fd, pages, cluster.count, (off_t)cluster.firstPage * globalFrameSize * sizeof(int));
+    threadStats[threadNum].stats.diskPageWrites += cluster.count;
+    threadStats[threadNum].stats.diskWriteOperations++;
+
+    for (int page = cluster.firstPage; page < cluster.firstPage + cluster.count; page++)
+    {
+        if (page == cluster.victimPage)
+            continue;
+        PageLock &pageLock = pageLockOf(page);
+        unique_lock<mutex> pageGuard(pageLock.lock, defer_lock);
+        if (concurrentMode)
+            pageGuard.lock();
+        pageTable[page].setWriteback(0);
+        pageTable.release(page);
+        if (concurrentMode)
+            pageLock.transitDone.notify_all();
+    }
+}
+
+// print physical memory
+void printPhysicalMemory()
+{
+    // print physical memory entries
+    for (int i = 0; i < physical_memory_size; i++)
+    {
+        int frameNumber = i / globalFrameSize;
+        cout << "Physical Memory Entry " << i << ": ";                                   // entry means every integer in the physical memory
+        cout << "Data: " << physicalMemory[i] << ", ";                                   // data is the random integer
+        cout << "Thread Number: " << frameTable[frameNumber].threadNum << ", ";          // thread number that the frame belongs to
+        cout << "Disk Index: " << frameTable[frameNumber].diskIndex + i % globalFrameSize << endl; // index of the data in the disk
+    }
+
+    /* print every begin of the frame
+    for (int i = 0; i < physical_memory_size; i += globalFrameSize)
+    {
+        cout << "Frame " << i / globalFrameSize << ": "; // frame number
+        for (int j = 0; j < globalFrameSize; j++)        // print the data in the frame
+        {
+            cout << physicalMemory[i + j] << " "; // data is the random integer
+        }
+        cout << endl;
+    }
+    */
+}
+
+// fill the virtual memory with tasks: fill the entire virtual memory with random integers. use the same random numbers for all runs of the program.
+void fillVirtualMemory(uint32_t threadNum)
+{
+    // fillVirtualMemory function is used to fill the entire virtual memory with random integers.
+    // before filling the virtual memory, call srand(1000) for thread 1 and call srand(2000) for thread 2
+
+    // srand(1000) for thread 1 and srand(2000) for thread 2. every thread keeps its own generator state,
+    // random_r with this state gives the same numbers as srand and rand
+    char randomState[128];
+    struct random_data randomData = {};
+    initstate_r(1000 * threadNum, randomState, sizeof(randomState), &randomData);
+
+    // size of the virtual memory
+    size_t size = virtual_page_number * globalFrameSize;
+
+    // according to thread nume fill the virtual memory with random integers, one page at a time
+    vector<int> page(globalFrameSize);
+    for (size_t i = 0; i < size; i += globalFrameSize)
+    {
+        for (int j = 0; j < globalFrameSize; j++)
+        {
+            // generate random integer
+            int32_t randomNumber;
+            random_r(&randomData, &randomNumber);
+            page[j] = randomNumber % 1000; // random integer
+        }
+        // set the values of the page in the virtual memory
+        setRange(threadNum, i, globalFrameSize, &page[0]);
+    }
+}
+
+// a page that the flusher or a clustered page-out is writing can not be evicted: it is clean, nothing would
+// write it again. the caller holds the pager lock
+inline bool underWriteback(int page)
+{
+    unique_lock<mutex> pageGuard(pageLockOf(page).lock, defer_lock);
+    if (concurrentMode)
+        pageGuard.lock();
+    return pageTable[page].writeback();
+}
+
+// oldest page of a list that can be evicted now, -1 if there is none
+int oldestEvictable(const PageLists &lists, int list)
+{
+    for (int page = lists.tail[list]; page != -1; page = lists.prev[page])
+    {
+        if (!underWriteback(page))
+            return page;
+    }
+    return -1;
+}
+
+// LRU: the least recently used page is the tail of the recency list
+struct LRUPolicy final : ReplacementPolicy
+{
+    PageLists lists; // list 0 is the recency list
+
+    LRUPolicy() : ReplacementPolicy(true) { lists.init(page_table_size); }
+    void onInsert(int pageIndex) { lists.pushFront(0, pageIndex); }
+    void onHit(int pageIndex) { lists.moveToFront(0, pageIndex); }
+    void onEvict(int pageIndex) { lists.unlink(pageIndex); }
+
+    int selectVictim()
+    {
+        if (!backgroundWriteback)
+            return oldestEvictable(lists, 0);
+
+        // with background write back take the least recently used clean page among the last ones
+        int dirtyCandidate = -1;
+        int page = lists.tail[0];
+        for (int step = 0; page != -1 && step < CLEAN_VICTIM_SCAN; step++, page = lists.prev[page])
+        {
+            lock_guard<mutex> pageGuard(pageLockOf(page).lock);
+            if (pageTable[page].writeback())
+                continue;
+            if (!pageTable[page].modified())
+                return page;
+            if (dirtyCandidate == -1)
+                dirtyCandidate = page;
+        }
+        return dirtyCandidate;
+    }
+};
+
+// Clock (CL): the hand sweeps the page table and evicts the first valid page whose referenced bit is 0. a sparse
+// page table has no entries to sweep, there the hand sweeps the frames. with local replacement the hand only
+// sweeps the pages of the owner process
+struct ClockPolicy final : ReplacementPolicy
+{
+    int clockHand; // clock hand for clock algorithm
+
+    ClockPolicy() : ReplacementPolicy(false), clockHand(0) {}
+
+    int selectVictim()
+    {
+        int dirtyCandidate = -1; // first dirty page that can be evicted, used if no clean page comes soon
+        int dirtyPassed = 0;
+
+        bool overFrames = (pageTable.mode != PAGE_TABLE_FLAT);
+        int positions = overFrames ? physical_frame_number : (owner ? process_page_number : page_table_size);
+        int firstPage = owner ? (owner - 1) * process_page_number : 0;
+
+        // two turns of the hand clear every referenced bit, so a valid page is found if there is any
+        for (int step = 0; step < 2 * positions; step++)
+        {
+            int page = overFrames ? frameTable[clockHand].pageIndex : firstPage + clockHand;
+
+            // update the clock hand for the next page
+            clockHand = (clockHand + 1) % positions;
+            if (page == -1 || !owns(page))
+                continue;
+
+            unique_lock<mutex> pageGuard(pageLockOf(page).lock, defer_lock);
+            if (concurrentMode)
+                pageGuard.lock();
+
+            // If Referenced bit is 0 and Valid bit is 1, then evict the page. Otherwise, set the Referenced bit to 0.
+            if (pageTable[page].valid() && pageTable[page].referenced() == 0)
+            {
+                // a page that is being written is passed over
+                if (pageTable[page].writeback())
+                    continue;
+                if (!backgroundWriteback)
+                    return page;
+
+                // with background write back a clean page is evicted without a disk write, the flusher cleans the dirty ones
+                if (!pageTable[page].modified())
+                    return page;
+                if (dirtyCandidate == -1)
+                    dirtyCandidate = page;
+                if (++dirtyPassed == CLEAN_VICTIM_SCAN)
+                    return dirtyCandidate;
+                continue;
+            }
+
+            // If referenced bit is 1, set it to 0 and move to the next page. the TLB entry is dropped too, so the
+            // next access walks the page table and sets the referenced bit again
+            if (pageTable[page].referenced())
+            {
+                pageTable[page].setReferenced(0);
+                tlbInvalidate(page);
+            }
+        }
+
+        // every frame is reserved by a page that is still in transit
+        return dirtyCandidate;
+    }
+};
+
+// WSClock (WSCL): the hand sweeps the frames. a referenced page gets its referenced bit cleared and the current
+// time as its last use. a page that was not used for more than window ticks of accessTick is out of the working
+// set: it is evicted if it is clean, a dirty one is given to the flusher (in background write back) and kept as
+// a candidate. if no old clean page is found, the first old dirty page or else the least recently used page goes
+struct WSClockPolicy final : ReplacementPolicy
+{
+    int hand;                   // frame the hand points to
+    unsigned long long window;  // working set window in ticks of accessTick
+
+    WSClockPolicy() : ReplacementPolicy(false), hand(0), window(2ULL * physical_frame_number) {}
+
+    int selectVictim()
+    {
+        unsigned long long now = accessTick;
+        int oldDirty = -1; // first dirty page out of the working set
+        int oldest = -1;   // least recently used page seen, the last resort
+        unsigned int oldestAge = 0;
+
+        // the first turn clears the referenced bits, the second one finds their pages out of the working set
+        for (int step = 0; step < 2 * physical_frame_number; step++)
+        {
+            int frameNumber = hand;
+            hand = (hand + 1) % physical_frame_number;
+            int page = frameTable[frameNumber].pageIndex;
+            if (page == -1 || !owns(page))
+                continue;
+
+            unique_lock<mutex> pageGuard(pageLockOf(page).lock, defer_lock);
+            if (concurrentMode)
+                pageGuard.lock();
+            // the frame is reserved for a fault in transit, or the flusher is writing the page
+            if (!pageTable[page].valid() || pageTable[page].frameNumber() != frameNumber || pageTable[page].writeback())
+                continue;
+
+            if (pageTable[page].referenced())
+            {
+                pageTable[page].setReferenced(0);
+                pageTable[page].setLastAccessTime(now);
+                tlbInvalidate(page);
+                continue;
+            }
+
+            unsigned int age = ticksSince(pageTable[page].lastAccessTime(), now);
+            if (oldest == -1 || age > oldestAge)
+            {
+                oldest = page;
+                oldestAge = age;
+            }
+            if (age <= window)
+                continue;
+
+            if (!pageTable[page].modified())
+                return page;
+            if (backgroundWriteback)
+                queueDirtyPage(page);
+            if (oldDirty == -1)
+                oldDirty = page;
+        }
+        return (oldDirty != -1) ? oldDirty : oldest;
+    }
+};
+
+// LFU: evicts the resident page with the fewest accesses since it was mapped, the least recently used one
+// among equals. the pages are ordered by (accesses, last use), the last use of every page is different
+struct LFUPolicy final : ReplacementPolicy
+{
+    typedef pair<unsigned int, unsigned long long> Key;
+    vector<unsigned int> accesses;      // accesses of every resident page
+    vector<unsigned long long> lastUse; // policy time of the last access of every resident page
+    unsigned long long time;            // advanced on every insert and hit
+    map<Key, int> order;                // (accesses, last use) -> page
+
+    LFUPolicy() : ReplacementPolicy(true), accesses(page_table_size, 0), lastUse(page_table_size, 0), time(0) {}
+
+    void onInsert(int pageIndex)
+    {
+        accesses[pageIndex] = 1;
+        lastUse[pageIndex] = ++time;
+        order[Key(accesses[pageIndex], lastUse[pageIndex])] = pageIndex;
+    }
+
+    void onHit(int pageIndex)
+    {
+        if (order.erase(Key(accesses[pageIndex], lastUse[pageIndex])) == 0)
+            return;
+        accesses[pageIndex]++;
+        lastUse[pageIndex] = ++time;
+        order[Key(accesses[pageIndex], lastUse[pageIndex])] = pageIndex;
+    }
+
+    void onEvict(int pageIndex)
+    {
+        order.erase(Key(accesses[pageIndex], lastUse[pageIndex]));
+    }
+
+    int selectVictim()
+    {
+        for (map<Key, int>::iterator it = order.begin(); it != order.end(); ++it)
+        {
+            if (!underWriteback(it->second))
+                return it->second;
+        }
+        return -1;
+    }
+};
+
+// NFU with aging (AGING): every page has an 8 bit age in its page table entry. about once per physical_frame_number ticks of accessTick
+// the referenced bit of every resident page is shifted into the top of its age and cleared. the page with the
+// smallest age goes, a page referenced since the last aging counts as younger than any other
+struct AgingPolicy final : ReplacementPolicy
+{
+    unsigned long long lastAging; // accessTick at the last aging
+
+    AgingPolicy() : ReplacementPolicy(false), lastAging(0) {}
+
+    void onInsert(int pageIndex) { pageTable[pageIndex].setAge(0); }
+
+    int selectVictim()
+    {
+        unsigned long long now = accessTick;
+        bool aging = (now - lastAging >= (unsigned long long)physical_frame_number);
+        if (aging)
+            lastAging = now;
+
+        int victim = -1;
+        unsigned int victimAge = 0;
+        for (int frameNumber = 0; frameNumber < physical_frame_number; frameNumber++)
+        {
+            int page = frameTable[frameNumber].pageIndex;
+            if (page == -1 || !owns(page))
+                continue;
+
+            unique_lock<mutex> pageGuard(pageLockOf(page).lock, defer_lock);
+            if (concurrentMode)
+                pageGuard.lock();
+            if (!pageTable[page].valid() || pageTable[page].frameNumber() != frameNumber)
+                continue;
+
+            if (aging)
+            {
+                pageTable[page].setAge((pageTable[page].age() >> 1) | (pageTable[page].referenced() ? 0x80 : 0));
+                if (pageTable[page].referenced())
+                {
+                    // the TLB entry is dropped too, so the next access sets the referenced bit again
+                    pageTable[page].setReferenced(0);
+                    tlbInvalidate(page);
+                }
+            }
+            if (pageTable[page].writeback())
+                continue;
+
+            unsigned int currentAge = (pageTable[page].referenced() ? 0x100 : 0) | pageTable[page].age();
+            if (victim == -1 || currentAge < victimAge)
+            {
+                victim = page;
+                victimAge = currentAge;
+            }
+        }
+        return victim;
+    }
+};
+
+// 2Q: a page seen for the first time goes to the FIFO A1in. when A1in holds more than a quarter of the frames
+// its oldest page is evicted and remembered in the ghost FIFO A1out. a fault on a page that is in A1out puts
+// it to the LRU list Am, the pages that are used again. a sequential scan only passes through A1in
+struct TwoQueuePolicy final : ReplacementPolicy
+{
+    enum { A1IN, AM, A1OUT };
+    PageLists lists;
+    int inLimit;    // pages A1in keeps before it gives up its oldest
+    int ghostLimit; // pages A1out remembers
+
+    TwoQueuePolicy() : ReplacementPolicy(true), inLimit(max(1, physical_frame_number / 4)), ghostLimit(max(1, physical_frame_number / 2))
+    {
+        lists.init(page_table_size);
+    }
+
+    void onInsert(int pageIndex)
+    {
+        bool seenBefore = (lists.owner[pageIndex] == A1OUT);
+        lists.unlink(pageIndex);
+        lists.pushFront(seenBefore ? AM : A1IN, pageIndex);
+    }
+
+    void onHit(int pageIndex)
+    {
+        if (lists.owner[pageIndex] == AM)
+            lists.moveToFront(AM, pageIndex);
+    }
+
+    void onEvict(int pageIndex)
+    {
+        bool firstSeen = (lists.owner[pageIndex] == A1IN);
+        lists.unlink(pageIndex);
+        if (!firstSeen)
+            return;
+        lists.pushFront(A1OUT, pageIndex);
+        if (lists.size[A1OUT] > ghostLimit)
+            lists.unlink(lists.tail[A1OUT]);
+    }
+
+    int selectVictim()
+    {
+        int first = (lists.size[A1IN] > inLimit || lists.size[AM] == 0) ? A1IN : AM;
+        int victim = oldestEvictable(lists, first);
+        return (victim != -1) ? victim : oldestEvictable(lists, first == A1IN ? AM : A1IN);
+    }
+};
+
+// ARC: T1 holds the pages used once and T2 the pages used more than once since they were mapped, both in
+// LRU order. the ghost lists B1 and B2 remember the pages evicted from them. a fault on a page in B1 means T1
+// should be longer and moves the target length p of T1 up, a fault on a page in B2 moves it down. the victim
+// comes from T1 if it is longer than p, from T2 otherwise
+struct ARCPolicy final : ReplacementPolicy
+{
+    enum { T1, T2, B1, B2 };
+    PageLists lists;
+    vector<char> ghostHit; // the page was in B1 or B2 at its last fault, it goes to T2
+    int capacity;          // c, the number of frames
+    int target;            // p, target length of T1
+    bool lastMissInB2;     // the fault being handled was on a page in B2
+
+    ARCPolicy() : ReplacementPolicy(true), ghostHit(page_table_size, 0), capacity(physical_frame_number), target(0), lastMissInB2(false)
+    {
+        lists.init(page_table_size);
+    }
+
+    void onMiss(int pageIndex)
+    {
+        int list = lists.owner[pageIndex];
+        lastMissInB2 = (list == B2);
+        if (list == B1)
+            target = min(capacity, target + max(1, lists.size[B2] / lists.size[B1]));
+        else if (list == B2)
+            target = max(0, target - max(1, lists.size[B1] / lists.size[B2]));
+        ghostHit[pageIndex] = (list == B1 || list == B2);
+        if (ghostHit[pageIndex])
+        {
+            lists.unlink(pageIndex);
+            return;
+        }
+
+        // a new page. keep T1 + B1 at most c and all four lists at most 2c
+        if (lists.size[T1] + lists.size[B1] >= capacity)
+        {
+            if (lists.size[B1] > 0)
+                lists.unlink(lists.tail[B1]);
+        }
+        else if (lists.size[T1] + lists.size[T2] + lists.size[B1] + lists.size[B2] >= 2 * capacity && lists.size[B2] > 0)
+        {
+            lists.unlink(lists.tail[B2]);
+        }
+    }
+
+    void onInsert(int pageIndex)
+    {
+        // a read ahead page may still be remembered in a ghost list
+        lists.unlink(pageIndex);
+        lists.pushFront(ghostHit[pageIndex] ? T2 : T1, pageIndex);
+        ghostHit[pageIndex] = 0;
+    }
+
+    void onHit(int pageIndex)
+    {
+        int list = lists.owner[pageIndex];
+        if (list == T1 || list == T2)
+            lists.moveToFront(T2, pageIndex);
+    }
+
+    void onEvict(int pageIndex)
+    {
+        int list = lists.owner[pageIndex];
+        lists.unlink(pageIndex);
+        if (list != T1 && list != T2)
+            return;
+        lists.pushFront(list == T1 ? B1 : B2, pageIndex);
+        while (lists.size[T1] + lists.size[B1] > capacity && lists.size[B1] > 0)
+            lists.unlink(lists.tail[B1]);
+        while (lists.size[T1] + lists.size[T2] + lists.size[B1] + lists.size[B2] > 2 * capacity && lists.size[B2] > 0)
+            lists.unlink(lists.tail[B2]);
+    }
+
+    int selectVictim()
+    {
+        bool fromT1 = lists.size[T1] > 0 && (lists.size[T1] > target || (lastMissInB2 && lists.size[T1] == target));
+        int victim = oldestEvictable(lists, fromT1 ? T1 : T2);
+        return (victim != -1) ? victim : oldestEvictable(lists, fromT1 ? T2 : T1);
+    }
+};
+
+// page replacement policy of a name on the command line, NULL for an unknown name
+ReplacementPolicy *createPolicy(const string &name, unsigned int owner = 0)
+{
+    ReplacementPolicy *created = NULL;
+    if (name == "LRU")
+        created = new LRUPolicy();
+    else if (name == "CL")
+        created = new ClockPolicy();
+    else if (name == "WSCL")
+        created = new WSClockPolicy();
+    else if (name == "LFU")
+        created = new LFUPolicy();
+    else if (name == "AGING")
+        created = new AgingPolicy();
+    else if (name == "2Q")
+        created = new TwoQueuePolicy();
+    else if (name == "ARC")
+        created = new ARCPolicy();
+    if (created != NULL)
+        created->owner = owner;
+    return created;
+}
+
+// local replacement. every process has its own instance of the replacement policy for its own pages and a frame
+// quota. a fault takes the frame of the process that is the furthest over its quota, so a process at its quota
+// replaces its own pages and a process under it takes frames from the others. the quotas:
+// fixed: the same share of the frames for every process
+// pff:   page fault frequency. a process that faults again within PFF_FAULT_INTERVAL of its own accesses may hold
+//        one frame more than it has, as long as the quotas fit in the physical memory. a process that faults less
+//        often keeps only its pages referenced since its last such fault and the faulting one
+// ws:    working set. a process samples the referenced bits of its frames once per WS_SAMPLE_ACCESSES of its own
+//        accesses, so the window is in the virtual time of the process. its working set is its pages referenced
+//        in the last two samples, the resident ones and the ones evicted meanwhile. the quotas are the working sets
+//        plus an equal share of the spare frames. when they do not all fit, the smallest working sets are kept whole
+//        and the processes that do not fit share the rest, like a working set scheduler that holds them back
+#define PFF_FAULT_INTERVAL 256 // accesses of a process between two faults below which it may grow
+#define WS_SAMPLE_ACCESSES (4 * physical_frame_number) // accesses of a process between two samples of its working set
+
+unsigned int pffLastFault[MAX_THREADS + 1];          // pff: reads and writes of the process at its last fault
+unsigned int wsLastSample[MAX_THREADS + 1];          // ws: reads and writes of the process at its last sample
+int workingSetSize[MAX_THREADS + 1];                 // ws: working set of the process at its last sample
+int wsEvicted[MAX_THREADS + 1];                      // ws: working set pages of the process evicted since its last sample
+
+// equal quotas and, under local replacement, a policy for every process
+void initializeFrameAllocation()
+{
+    for (int t = 0; t <= MAX_THREADS; t++)
+    {
+        delete processPolicies[t];
+        processPolicies[t] = NULL;
+        frameQuota[t] = 0;
+        pffLastFault[t] = 0;
+        wsLastSample[t] = 0;
+        workingSetSize[t] = 0;
+        wsEvicted[t] = 0;
+    }
+    for (int t = 1; t <= numThreads; t++)
+    {
+        frameQuota[t] = max(1, physical_frame_number / numThreads + (t <= physical_frame_number % numThreads));
+        workingSetSize[t] = frameQuota[t];
+        if (frameAllocation != ALLOCATION_GLOBAL)
+            processPolicies[t] = createPolicy(pageReplacement, t);
+    }
+}
+
+// shift the referenced bits of the frames of a process into their history and clear them, and drop the TLB
+// entries, so the next scan only sees the pages used after this one. returns the frames whose history has one
+// of the bits of the mask set. the caller holds the pager lock
+int scanReferencedFrames(unsigned int threadNum, unsigned char historyMask)
+{
+    int count = 0;
+    for (int frameNumber = 0; frameNumber < physical_frame_number; frameNumber++)
+    {
+        int page = frameTable[frameNumber].pageIndex;
+        if (page == -1 || frameTable[frameNumber].threadNum != (int)threadNum)
+            continue;
+
+        unique_lock<mutex> pageGuard(pageLockOf(page).lock, defer_lock);
+        if (concurrentMode)
+            pageGuard.lock();
+        if (!pageTable[page].valid() || pageTable[page].frameNumber() != frameNumber)
+            continue;
+
+        int referenced = pageTable[page].referenced();
+        frameHistory[frameNumber] = ((frameHistory[frameNumber] << 1) | referenced) & 3;
+        if (referenced)
+        {
+            pageTable[page].setReferenced(0);
+            tlbInvalidate(page);
+        }
+        if (frameHistory[frameNumber] & historyMask)
+            count++;
+    }
+    return count;
+}
+
+// pff: set the quota of a process at its fault. the caller holds the pager lock and is the process itself
+void pffFault(unsigned int threadNum)
+{
+    const Statistics &stats = threadStats[threadNum].stats;
+    unsigned int accesses = stats.reads + stats.writes;
+    if (accesses - pffLastFault[threadNum] < PFF_FAULT_INTERVAL)
+    {
+        int others = 0;
+        for (int t = 1; t <= numThreads; t++)
+            if (t != (int)threadNum)
+                others += frameQuota[t];
+        frameQuota[threadNum] = max(frameQuota[threadNum], min(physical_frame_number - others, framesHeld[threadNum] + 1));
+    }
+    else
+        frameQuota[threadNum] = scanReferencedFrames(threadNum, 1) + 1;
+    pffLastFault[threadNum] = accesses;
+}
+
+// ws: sample the working set of a process and set the quotas from the working sets. the caller is the process
+// itself
+void sampleWorkingSet(unsigned int threadNum)
+{
+    const Statistics &stats = threadStats[threadNum].stats;
+    wsLastSample[threadNum] = stats.reads + stats.writes;
+
+    unique_lock<mutex> pagerGuard(pagerMutex, defer_lock);
+    if (concurrentMode)
+        pagerGuard.lock();
+    workingSetSize[threadNum] = max(1, scanReferencedFrames(threadNum, 3) + wsEvicted[threadNum]);
+    wsEvicted[threadNum] = 0;
+
+    long long total = 0;
+    for (int t = 1; t <= numThreads; t++)
+        total += workingSetSize[t];
+    if (total <= physical_frame_number)
+    {
+        for (int t = 1; t <= numThreads; t++)
+            frameQuota[t] = workingSetSize[t] + (int)((physical_frame_number - total) / numThreads);
+        return;
+    }
+
+    vector<pair<int, int>> bySize; // (working set, process), smallest first
+    for (int t = 1; t <= numThreads; t++)
+        bySize.push_back(make_pair(workingSetSize[t], t));
+    sort(bySize.begin(), bySize.end());
+    int remaining = physical_frame_number;
+    for (int i = 0; i < numThreads; i++)
+    {
+        if (bySize[i].first > remaining)
+        {
+            // this and every larger working set do not fit, they share the rest
+            for (int j = i; j < numThreads; j++)
+                frameQuota[bySize[j].second] = max(1, remaining / (numThreads - i));
+            return;
+        }
+        frameQuota[bySize[i].second] = bySize[i].first;
+        remaining -= bySize[i].first;
+    }
+}
+
+// victim for a fault of a process, -1 if every frame is reserved by a fault in transit. the caller holds the pager lock
+int chooseVictim(unsigned int threadNum)
+{
+    if (frameAllocation == ALLOCATION_GLOBAL)
+        return policy->selectVictim();
+
+    // the process the furthest over its quota gives the frame, the faulting process on a tie. if every frame of
+    // that process is in transit the next one is tried
+    bool tried[MAX_THREADS + 1] = {false};
+    for (int attempt = 0; attempt < numThreads; attempt++)
+    {
+        int donor = -1;
+        for (int t = 1; t <= numThreads; t++)
+        {
+            if (tried[t] || framesHeld[t] == 0)
+                continue;
+            int excess = framesHeld[t] - frameQuota[t];
+            int donorExcess = (donor == -1) ? 0 : framesHeld[donor] - frameQuota[donor];
+            if (donor == -1 || excess > donorExcess || (excess == donorExcess && t == (int)threadNum))
+                donor = t;
+        }
+        if (donor == -1)
+            return -1;
+        int victim = processPolicies[donor]->selectVictim();
+        if (victim != -1)
+            return victim;
+        tried[donor] = true;
+    }
+    return -1;
+}
+
+// unmap the victim page and return its frame. the caller holds the pager lock. if the page is modified
+// it stays in transit until the caller writes it to the disk and calls finishTransit
+int evictPage(int victimPage, bool &modified)
+{
+    unique_lock<mutex> pageGuard(pageLockOf(victimPage).lock, defer_lock);
+    if (concurrentMode)
+        pageGuard.lock();
+
+    policyOf(victimPage)->onEvict(victimPage);
+    tlbInvalidate(victimPage);
+
+    int frameNumber = pageTable[victimPage].frameNumber();
+    modified = pageTable[victimPage].modified();
+    if (frameAllocation == ALLOCATION_WS && (pageTable[victimPage].referenced() || frameHistory[frameNumber]))
+        wsEvicted[victimPage / process_page_number + 1]++;
+    if (pageTable[victimPage].prefetched())
+    {
+        // the thread that read the page ahead, a worker of a shared address space too
+        readaheadStates[frameTable[frameNumber].threadNum].wastedPages++;
+        pageTable[victimPage].setPrefetched(0);
+    }
+
+    // update the page table entry for the evicted page
+    pageTable[victimPage].setValid(0);
+    pageTable[victimPage].setModified(0);
+    pageTable[victimPage].setReferenced(0);
+    pageTable[victimPage].setLastAccessTime(0);
+    pageTable[victimPage].setFrameNumber(-1);
+    pageTable[victimPage].setInTransit(modified);
+    pageTable.release(victimPage);
+    return frameNumber;
+}
+
+// the disk transfer of a page is done. wake up the threads that wait for it
+void finishTransit(int pageIndex)
+{
+    PageLock &pageLock = pageLockOf(pageIndex);
+    unique_lock<mutex> pageGuard(pageLock.lock, defer_lock);
+    if (concurrentMode)
+        pageGuard.lock();
+
+    pageTable[pageIndex].setInTransit(0);
+    pageTable.release(pageIndex);
+    if (concurrentMode)
+        pageLock.transitDone.notify_all();
+}
+
+// drop a page that its process does not need any more, like munmap. the content is not written back: the disk
+// slot and the zswap copy of the page are dropped too, so the next access finds the initial content of the disk.
+// a resident page gives its frame back to the free frame stack
+void releasePage(int pageIndex)
+{
+    unique_lock<mutex> pagerGuard(pagerMutex, defer_lock);
+    unique_lock<mutex> pageGuard(pageLockOf(pageIndex).lock, defer_lock);
+    if (concurrentMode)
+    {
+        pagerGuard.lock();
+        pageGuard.lock();
+    }
+
+    // an eviction or the flusher may still be writing the page, its write must not land after the drop
+    if (concurrentMode)
+    {
+        while (pageTable[pageIndex].inTransit() || pageTable[pageIndex].writeback())
+            pageLockOf(pageIndex).transitDone.wait(pageGuard);
+    }
+
+    if (pageTable[pageIndex].valid())
+    {
+        int frameNumber = pageTable[pageIndex].frameNumber();
+        policyOf(pageIndex)->onEvict(pageIndex);
+        tlbInvalidate(pageIndex);
+        pageTable[pageIndex].setValid(0);
+        pageTable[pageIndex].setModified(0);
+        pageTable[pageIndex].setReferenced(0);
+        pageTable[pageIndex].setPrefetched(0);
+        pageTable[pageIndex].setLastAccessTime(0);
+        pageTable[pageIndex].setFrameNumber(-1);
+        releaseFrame(frameNumber);
+    }
+    pageTable.release(pageIndex);
+    zswapInvalidate(pageIndex);
+    diskPageWritten[pageIndex].store(0, memory_order_relaxed);
+}
+
+// check=on: every frame is on the free frame stack once or is mapped by the page it belongs to, and every
+// process holds the frames that it is charged for. the processes are done. returns false after printing the error
+bool checkFrameTable()
+{
+    vector<char> free(physical_frame_number, 0);
+    for (size_t i = 0; i < freeFrames.size(); i++)
+    {
+        int frameNumber = freeFrames[i];
+        if (free[frameNumber] || frameTable[frameNumber].threadNum != -1 || frameTable[frameNumber].pageIndex != -1)
+        {
+            cout << "Error: free frame " << frameNumber << " is on the free frame stack twice or has an owner" << endl;
+            return false;
+        }
+        free[frameNumber] = 1;
+    }
+
+    int held[MAX_THREADS + 1] = {0};
+    for (int frameNumber = 0; frameNumber < physical_frame_number; frameNumber++)
+    {
+        if (free[frameNumber])
+            continue;
+        int page = frameTable[frameNumber].pageIndex;
+        if (page == -1 || !pageTable[page].valid() || pageTable[page].frameNumber() != frameNumber)
+        {
+            cout << "Error: frame " << frameNumber << " is neither free nor mapped by its page" << endl;
+            return false;
+        }
+        held[frameTable[frameNumber].threadNum]++;
+    }
+    for (int t = 1; t <= numThreads; t++)
+    {
+        if (held[t] != framesHeld[t])
+        {
+            cout << "Error: process " << t << " holds " << held[t] << " frames but is charged for " << framesHeld[t] << endl;
+            return false;
+        }
+    }
+    printf("Frame table check: %zu frames free, %zu mapped\n", freeFrames.size(), physical_frame_number - freeFrames.size());
+    return true;
+}
+
+// background write back. every page that becomes modified is put on the dirty page queue. when the queue is
+// longer than dirtyBackgroundLimit the flusher thread writes the oldest dirty pages back, so the evictor mostly
+// finds clean victims and the faulting process does not wait for a write. stopFlusher writes back the rest.
+deque<int> dirtyQueue;           // pages in the order they became modified. evicted or cleaned pages are skipped
+mutex flushMutex;                // protects dirtyQueue and flusherStop. locked after any page lock
+condition_variable flushWork;    // wakes the flusher
+bool flusherStop = false;        // set at shutdown, the flusher empties the queue and exits
+int dirtyBackgroundLimit = 0;    // queued pages that are left to the evictor
+thread flusherThread;
+
+// put a page that became modified on the dirty page queue
+void queueDirtyPage(int pageIndex)
+{
+    lock_guard<mutex> flushGuard(flushMutex);
+    dirtyQueue.push_back(pageIndex);
+    if ((int)dirtyQueue.size() > dirtyBackgroundLimit)
+        flushWork.notify_one();
+}
+
+// set the modified bit of a page. the caller holds the page lock
+inline void markDirty(int pageIndex)
+{
+    if (pageTable[pageIndex].modified())
+        return;
+    pageTable[pageIndex].setModified(1);
+    if (backgroundWriteback)
+        queueDirtyPage(pageIndex);
+}
+
+// write one dirty page back ahead of its eviction. the page is copied and marked clean under its lock and the
+// copy is written without any lock. writes that come meanwhile set the modified bit again. the page is not
+// evicted until the write is done, so a later read of the page can not overtake it
+void flushPage(int pageIndex, vector<int> &copy)
+{
+    PageLock &pageLock = pageLockOf(pageIndex);
+    {
+        lock_guard<mutex> pagerGuard(pagerMutex);
+        lock_guard<mutex> pageGuard(pageLock.lock);
+        if (!pageTable[pageIndex].valid() || !pageTable[pageIndex].modified() || pageTable[pageIndex].writeback())
+            return;
+        memcpy(&copy[0], &physicalMemory[pageTable[pageIndex].frameNumber() * globalFrameSize], globalFrameSize * sizeof(int));
+        pageTable[pageIndex].setModified(0);
+        pageTable[pageIndex].setWriteback(1);
+        tlbClearDirty(pageIndex);
+    }
+
+    diskPageWritten[pageIndex].store(1, memory_order_relaxed);
+    zswapInvalidate(pageIndex);
+    if (mmapDisk)
+        memcpy(&diskMapping[(size_t)pageIndex * globalFrameSize], &copy[0], globalFrameSize * sizeof(int));
+    else
+        pwrite(fd, &copy[0], globalFrameSize * sizeof(int), (off_t)pageIndex * globalFrameSize * sizeof(int));
+    backgroundPageWrites[pageIndex / process_page_number + 1].fetch_add(1, memory_order_relaxed);
+    if (telemetryEnabled)
+        telemetryAdd(telemetry[0].diskPageWrites, 1);
+
+    lock_guard<mutex> pageGuard(pageLock.lock);
+    pageTable[pageIndex].setWriteback(0);
+    pageLock.transitDone.notify_all();
+}
+
+// flusher thread: keep the dirty page queue at dirtyBackgroundLimit, empty it at shutdown
+void flusherMain()
+{
+    vector<int> copy(globalFrameSize);
+    unique_lock<mutex> flushGuard(flushMutex);
+    while (true)
+    {
+        flushWork.wait(flushGuard, [] { return flusherStop || (int)dirtyQueue.size() > dirtyBackgroundLimit; });
+        if (dirtyQueue.empty())
+            return;
+
+        int pageIndex = dirtyQueue.front();
+        dirtyQueue.pop_front();
+        flushGuard.unlock();
+        flushPage(pageIndex, copy);
+        flushGuard.lock();
+    }
+}
+
+// start the flusher thread of the current simulation
+void startFlusher()
+{
+    dirtyQueue.clear();
+    flusherStop = false;
+    dirtyBackgroundLimit = max(1, physical_frame_number / 4);
+    flusherThread = thread(flusherMain);
+}
+
+// final flush: write back every dirty page and stop the flusher thread, then write back the zswap pool
+void stopFlusher()
+{
+    {
+        lock_guard<mutex> flushGuard(flushMutex);
+        flusherStop = true;
+    }
+    flushWork.notify_one();
+    flusherThread.join();
+    if (zswapPoolPages > 0)
+        zswapFlush();
+}
+
+// pager engines. the access path is a template on log2 of the page size and on the replacement policy.
+// initializeSimulation picks the instance of the page size and the policy of the simulation, so an access
+// finds its page and offset with a shift and a mask and the policy hooks are direct calls that are inlined,
+// the policies are final. the generic instance divides by globalFrameSize and calls the hooks through the
+// virtual functions, it runs for page sizes above 2^ENGINE_MAX_PAGE_SHIFT and with engine=generic
+#define RUNTIME_PAGE_SHIFT -1   // page size of the generic engine, globalFrameSize
+#define ENGINE_MAX_PAGE_SHIFT 10 // largest log2 of the page size that has its own engines
+
+// page and offset of a virtual memory index, first index of a frame in the physical memory
+template <int PageShift>
+struct PageGeometry
+{
+    static int pageOf(unsigned int index) { return index >> PageShift; }
+    static int offsetOf(unsigned int index) { return index & ((1u << PageShift) - 1); }
+    static int frameStart(int frameNumber) { return frameNumber << PageShift; }
+};
+
+template <>
+struct PageGeometry<RUNTIME_PAGE_SHIFT>
+{
+    static int pageOf(unsigned int index) { return index / globalFrameSize; }
+    static int offsetOf(unsigned int index) { return index % globalFrameSize; }
+    static int frameStart(int frameNumber) { return frameNumber * globalFrameSize; }
+};
+
+// replacement policy of a page as the policy type of an engine. the hooks of a final policy are called
+// directly, the ones of ReplacementPolicy through the virtual functions
+template <class Policy>
+inline Policy *enginePolicyOf(int pageIndex)
+{
+    return static_cast<Policy *>(policyOf(pageIndex));
+}
+
+// copy count integers between a frame and a buffer
+template <int PageShift>
+inline void copyFrameData(int frameNumber, int offset, int count, int *buffer, bool isWrite)
+{
+    int *data = &physicalMemory[PageGeometry<PageShift>::frameStart(frameNumber) + offset];
+    if (count == 1)
+    {
+        if (isWrite)
+            *data = *buffer;
+        else
+            *buffer = *data;
+    }
+    else if (isWrite)
+    {
+        memcpy(data, buffer, count * sizeof(int));
+    }
+    else
+    {
+        memcpy(buffer, data, count * sizeof(int));
+    }
+}
+
+// read or write integers of a resident page and update its page table entry. the caller holds the page lock
+template <int PageShift>
+inline void accessResidentPage(int pageIndex, int offset, int count, int *buffer, bool isWrite, unsigned long long accessTime)
+{
+    pageTable[pageIndex].setReferenced(1);
+    pageTable[pageIndex].setLastAccessTime(accessTime);
+    if (isWrite)
+        markDirty(pageIndex);
+    copyFrameData<PageShift>(pageTable[pageIndex].frameNumber(), offset, count, buffer, isWrite);
+}
+
+// access trace. with trace=file every call of accessPage is recorded as (thread, index, count, read/write) in a
+// binary file: a TraceHeader and then TraceRecords. every process fills its own buffer and appends it to the
+// file when it is full, so the records of one process are in order and the processes interleave in blocks
+#define TRACE_MAGIC 0x31544D56 // "VMT1"
+#define TRACE_BUFFER_RECORDS 8192
+
+struct TraceHeader
+{
+    uint32_t magic;
+    uint32_t frameSize;       // integers in a page
+    uint32_t pagesPerProcess; // process_page_number of the recorded run
+    uint32_t threads;         // number of processes of the recorded run
+};
+
+// one access of a page: count integers from index, by a process
+struct TraceRecord
+{
+    uint32_t index; // virtual memory index in the process
+    uint32_t info;  // thread << 25 | isWrite << 24 | count
+};
+
+struct alignas(64) TraceBuffer
+{
+    vector<TraceRecord> records;
+};
+
+int traceFd = -1;                        // trace file, -1 when no trace is recorded
+mutex traceMutex;                        // appends of the buffers to the trace file
+TraceBuffer traceBuffers[MAX_THREADS + 1]; // buffer of every process, indexed by thread number
+
+// append the records of a process to the trace file
+void flushTraceBuffer(unsigned int threadNum)
+{
+    vector<TraceRecord> &records = traceBuffers[threadNum].records;
+    if (records.empty())
+        return;
+    lock_guard<mutex> traceGuard(traceMutex);
+    write(traceFd, &records[0], records.size() * sizeof(TraceRecord));
+    records.clear();
+}
+
+// record one access
+inline void recordAccess(unsigned int threadNum, unsigned int index, int count, bool isWrite)
+{
+    // the workers of a shared address space are recorded as process 1
+    TraceRecord record = {index, ((sharedAddressSpace ? 1 : threadNum) << 25) | ((isWrite ? 1u : 0u) << 24) | (unsigned int)count};
+    vector<TraceRecord> &records = traceBuffers[threadNum].records;
+    records.push_back(record);
+    if (records.size() == TRACE_BUFFER_RECORDS)
+        flushTraceBuffer(threadNum);
+}
+
+// start recording the accesses of the current simulation
+void openTrace(const string &traceFileName)
+{
+    traceFd = open(traceFileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (traceFd == -1)
+    {
+        cout << "Error: Cannot open trace file" << endl;
+        exit(1);
+    }
+    TraceHeader header = {TRACE_MAGIC, (uint32_t)globalFrameSize, (uint32_t)process_page_number, (uint32_t)(sharedAddressSpace ? 1 : numThreads)};
+    write(traceFd, &header, sizeof(header));
+    for (int t = 0; t <= MAX_THREADS; t++)
+    {
+        traceBuffers[t].records.clear();
+        traceBuffers[t].records.reserve(TRACE_BUFFER_RECORDS);
+    }
+}
+
+// write the rest of the buffers and close the trace file. the processes are finished
+void closeTrace()
+{
+    for (int t = 1; t <= numThreads; t++)
+    {
+        flushTraceBuffer(t);
+    }
+    close(traceFd);
+    traceFd = -1;
+}
+
+// hits of the policies that keep track of them (LRU, LFU, 2Q and ARC) in the concurrent mode. a hit only takes
+// the lock of its page, so the hits of a process are put in its own buffer and given to the policy under the
+// pager lock: when the buffer is full, and when the process takes the pager lock for a fault anyway. repeated
+// hits of the same page share a slot. a page that was evicted before its hits are given is skipped
+#define HIT_BUFFER_PAGES 32
+
+struct alignas(64) HitBuffer
+{
+    int pages[HIT_BUFFER_PAGES];          // pages hit since the last drain, in the order of their hits
+    unsigned int hits[HIT_BUFFER_PAGES];  // hits of every page in a row
+    int count;                            // used slots
+};
+
+HitBuffer hitBuffers[MAX_THREADS + 1]; // hit buffer of every process, only the process itself uses it
+
+// give the buffered hits of a process to the policy. the caller holds the pager lock
+template <class Policy>
+void drainHits(unsigned int threadNum)
+{
+    HitBuffer &buffer = hitBuffers[threadNum];
+    for (int i = 0; i < buffer.count; i++)
+    {
+        int page = buffer.pages[i];
+        // the chains of the inverted page table are only walked under the page lock
+        unique_lock<mutex> pageGuard(pageLockOf(page).lock, defer_lock);
+        if (pageTable.mode == PAGE_TABLE_INVERTED)
+            pageGuard.lock();
+        if (!pageTable[page].valid())
+            continue;
+        Policy *replacer = enginePolicyOf<Policy>(page);
+        for (unsigned int h = 0; h < buffer.hits[i]; h++)
+            replacer->onHit(page);
+    }
+    buffer.count = 0;
+}
+
+// tell the replacement policy about a hit, if it keeps track of them
+template <class Policy>
+inline void touchRecentlyUsed(unsigned int threadNum, int pageIndex)
+{
+    Policy *replacer = enginePolicyOf<Policy>(pageIndex);
+    if (!replacer->tracksHits)
+        return;
+    if (!concurrentMode)
+    {
+        replacer->onHit(pageIndex);
+        return;
+    }
+
+    HitBuffer &buffer = hitBuffers[threadNum];
+    if (buffer.count > 0 && buffer.pages[buffer.count - 1] == pageIndex)
+    {
+        buffer.hits[buffer.count - 1]++;
+        return;
+    }
+    if (buffer.count == HIT_BUFFER_PAGES)
+    {
+        lock_guard<mutex> pagerGuard(pagerMutex);
+        drainHits<Policy>(threadNum);
+    }
+    buffer.pages[buffer.count] = pageIndex;
+    buffer.hits[buffer.count] = 1;
+    buffer.count++;
+}
+
+// dump=text|file: at every pageTablePrintInt memory accesses the page table is printed, or a binary snapshot of
+// it is appended to the file. a snapshot is a PageTableSnapshotHeader and then a PageTableSnapshotEntry for every
+// entry that printPageTable prints; the entry word has the bit layout of PTE_FRAME_MASK to PTE_TIME_SHIFT.
+// without dump the access counter is not kept at all
+enum PageTableDump
+{
+    DUMP_OFF,
+    DUMP_TEXT,
+    DUMP_BINARY
+};
+PageTableDump pageTableDump = DUMP_OFF;
+int dumpFd = -1; // file of the binary snapshots
+
+#define SNAPSHOT_MAGIC 0x31535450 // "PTS1"
+
+struct PageTableSnapshotHeader
+{
+    uint32_t magic;
+    uint32_t entries;             // PageTableSnapshotEntries after the header
+    uint64_t memoryAccesses;      // memoryAccessCounter when the snapshot was taken
+    uint64_t accessTick;          // accessTick when the snapshot was taken, the time base of the entries
+};
+
+struct PageTableSnapshotEntry
+{
+    uint32_t pageIndex;
+    uint32_t reserved;
+    uint64_t entry; // the page table entry word
+};
+
+// append a binary snapshot of the page table to the dump file
+void writePageTableSnapshot(unsigned int memoryAccesses)
+{
+    vector<PageTableSnapshotEntry> entries;
+    visitPageTable([&entries](int i, const PageTableEntry &entry) {
+        PageTableSnapshotEntry record = {(uint32_t)i, 0, entry.load()};
+        entries.push_back(record);
+    });
+    PageTableSnapshotHeader header = {SNAPSHOT_MAGIC, (uint32_t)entries.size(), memoryAccesses, accessTick.load()};
+    struct iovec parts[2] = {{&header, sizeof(header)}, {entries.data(), entries.size() * sizeof(PageTableSnapshotEntry)}};
+    writev(dumpFd, parts, 2);
+}
+
+// dump the page table at every pageTablePrintInt memory accesses. a range access counts one access per integer
+inline void countMemoryAccess(int count)
+{
+    if (pageTableDump == DUMP_OFF)
+        return;
+    unsigned int before = memoryAccessCounter.fetch_add(count);
+    if (before / pageTablePrintInt != (before + count) / pageTablePrintInt)
+    {
+        if (pageTableDump == DUMP_TEXT)
+            printPageTable();
+        else
+            writePageTableSnapshot(before + count);
+    }
+}
+
+// telemetry sampler. every telemetryIntervalMs the sampler thread sums the telemetry counters of all processes
+// and writes a row to the telemetry file: a CSV line, or an object of the snapshots array of a JSON file. the
+// last row is written when the sampler stops, with the fault latency histogram after it in a JSON file
+string telemetryFileName;          // telemetry=file, JSON if the name ends with .json
+int telemetryIntervalMs = 100;     // telemetryms=N
+FILE *telemetryFile = NULL;
+bool telemetryJson = false;
+bool telemetryStop = false;        // set when the sampler writes its last row
+mutex telemetryMutex;              // protects telemetryStop
+condition_variable telemetryWake;  // wakes the sampler to stop
+thread telemetryThread;
+
+struct TelemetrySample
+{
+    double elapsedMs;
+    unsigned long long accesses;
+    unsigned long long faults;
+    unsigned long long diskPageReads;
+    unsigned long long diskPageWrites;
+    unsigned long long faultLatency[TELEMETRY_LATENCY_BUCKETS];
+};
+
+// sum of the telemetry counters of the flusher and the processes
+TelemetrySample sampleTelemetry(double elapsedMs)
+{
+    TelemetrySample sample = {elapsedMs, 0, 0, 0, 0, {0}};
+    for (int t = 0; t <= numThreads; t++)
+    {
+        TelemetryCounters &counters = telemetry[t];
+        sample.accesses += counters.accesses.load(memory_order_relaxed);
+        sample.faults += counters.faults.load(memory_order_relaxed);
+        sample.diskPageReads += counters.diskPageReads.load(memory_order_relaxed);
+        sample.diskPageWrites += counters.diskPageWrites.load(memory_order_relaxed);
+        for (int b = 0; b < TELEMETRY_LATENCY_BUCKETS; b++)
+            sample.faultLatency[b] += counters.faultLatency[b].load(memory_order_relaxed);
+    }
+    return sample;
+}
+
+// upper end of the histogram bucket that holds the given fraction of the faults, 0 without faults
+unsigned long long latencyPercentile(const TelemetrySample &sample, double fraction)
+{
+    unsigned long long seen = 0;
+    for (int b = 0; b < TELEMETRY_LATENCY_BUCKETS; b++)
+    {
+        seen += sample.faultLatency[b];
+        if (seen > 0 && seen >= fraction * sample.faults)
+            return 1ULL << (b + 1);
+    }
+    return 0;
+}
+
+void writeTelemetryRow(const TelemetrySample &sample, const TelemetrySample &previous, bool first)
+{
+    double seconds = (sample.elapsedMs - previous.elapsedMs) / 1000;
+    double faultsPerSecond = seconds > 0 ? (sample.faults - previous.faults) / seconds : 0;
+    if (telemetryJson)
+        fprintf(telemetryFile, "%s\n    {\"elapsed_ms\": %.1f, \"accesses\": %llu, \"faults\": %llu, \"disk_reads\": %llu, \"disk_writes\": %llu, \"faults_per_sec\": %.0f, \"p50_fault_ns\": %llu, \"p99_fault_ns\": %llu}",
+                first ? "" : ",", sample.elapsedMs, sample.accesses, sample.faults, sample.diskPageReads, sample.diskPageWrites,
+                faultsPerSecond, latencyPercentile(sample, 0.5), latencyPercentile(sample, 0.99));
+    else
+        fprintf(telemetryFile, "%.1f,%llu,%llu,%llu,%llu,%.0f,%llu,%llu\n", sample.elapsedMs, sample.accesses, sample.faults,
+                sample.diskPageReads, sample.diskPageWrites, faultsPerSecond, latencyPercentile(sample, 0.5), latencyPercentile(sample, 0.99));
+}
+
+// sampler thread: a row every telemetryIntervalMs until stopTelemetry
+void telemetryMain()
+{
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    TelemetrySample previous = sampleTelemetry(0);
+    bool first = true;
+    unique_lock<mutex> telemetryGuard(telemetryMutex);
+    while (!telemetryWake.wait_for(telemetryGuard, chrono::milliseconds(telemetryIntervalMs), [] { return telemetryStop; }))
+    {
+        TelemetrySample sample = sampleTelemetry(chrono::duration<double, milli>(chrono::steady_clock::now() - start).count());
+        writeTelemetryRow(sample, previous, first);
+        previous = sample;
+        first = false;
+    }
+
+    // the processes are done, the last row has their final disk page reads and writes
+    TelemetrySample sample = sampleTelemetry(chrono::duration<double, milli>(chrono::steady_clock::now() - start).count());
+    sample.diskPageReads = 0;
+    sample.diskPageWrites = telemetry[0].diskPageWrites.load(memory_order_relaxed);
+    for (int t = 1; t <= numThreads; t++)
+    {
+        sample.diskPageReads += threadStats[t].stats.diskPageReads;
+        sample.diskPageWrites += threadStats[t].stats.diskPageWrites;
+    }
+    writeTelemetryRow(sample, previous, first);
+    if (telemetryJson)
+    {
+        fprintf(telemetryFile, "\n  ],\n  \"fault_latency_ns\": [");
+        for (int b = 0; b < TELEMETRY_LATENCY_BUCKETS; b++)
+            fprintf(telemetryFile, "%s\n    {\"from\": %llu, \"to\": %llu, \"faults\": %llu}", b ? "," : "", 1ULL << b, 1ULL << (b + 1), sample.faultLatency[b]);
+        fprintf(telemetryFile, "\n  ]\n}\n");
+    }
+}
+
+// open the telemetry file, reset the counters and start the sampler thread. returns false if the file can not be opened
+bool startTelemetry()
+{
+    telemetryFile = fopen(telemetryFileName.c_str(), "w");
+    if (telemetryFile == NULL)
+    {
+        cout << "Error: Cannot open " << telemetryFileName << endl;
+        return false;
+    }
+    telemetryJson = telemetryFileName.size() >= 5 && telemetryFileName.compare(telemetryFileName.size() - 5, 5, ".json") == 0;
+    if (telemetryJson)
+        fprintf(telemetryFile, "{\n  \"interval_ms\": %d,\n  \"snapshots\": [", telemetryIntervalMs);
+    else
+        fprintf(telemetryFile, "elapsed_ms,accesses,faults,disk_reads,disk_writes,faults_per_sec,p50_fault_ns,p99_fault_ns\n");
+
+    for (int t = 0; t <= MAX_THREADS; t++)
+    {
+        telemetry[t].accesses = 0;
+        telemetry[t].faults = 0;
+        telemetry[t].diskPageReads = 0;
+        telemetry[t].diskPageWrites = 0;
+        for (int b = 0; b < TELEMETRY_LATENCY_BUCKETS; b++)
+            telemetry[t].faultLatency[b] = 0;
+    }
+    telemetryStop = false;
+    telemetryEnabled = true;
+    telemetryThread = thread(telemetryMain);
+    return true;
+}
+
+// write the last row and stop the sampler thread. the processes are done
+void stopTelemetry()
+{
+    {
+        lock_guard<mutex> telemetryGuard(telemetryMutex);
+        telemetryStop = true;
+    }
+    telemetryWake.notify_one();
+    telemetryThread.join();
+    telemetryEnabled = false;
+    fclose(telemetryFile);
+    telemetryFile = NULL;
+}
+
+// print the fault latency histogram of the run, the buckets that have faults
+void printFaultLatency()
+{
+    TelemetrySample sample = sampleTelemetry(0);
+    printf("┌──────────────────────────────┬────────────┐\n");
+    printf("│ Fault Latency                │     Faults │\n");
+    printf("├──────────────────────────────┼────────────┤\n");
+    for (int b = 0; b < TELEMETRY_LATENCY_BUCKETS; b++)
+    {
+        if (sample.faultLatency[b] == 0)
+            continue;
+        char range[32];
+        snprintf(range, sizeof(range), "%llu - %llu ns", 1ULL << b, 1ULL << (b + 1));
+        printf("│ %-28s │ %10llu │\n", range, sample.faultLatency[b]);
+    }
+    printf("└──────────────────────────────┴────────────┘\n");
+}
+
+// a page that is read ahead of a fault, with the frame reserved for it
+struct ReadaheadPage
+{
+    int pageIndex;          // page that is read ahead
+    int frameNumber;        // frame reserved for the page
+    int victimPage;         // page that was evicted from the frame, -1 if the frame was free
+    bool victimModified;    // the victim has to be written back before the frame is read into
+    PageoutCluster cluster; // the modified victim and its dirty neighbours
+};
+
+// decide if a fault on pageIndex continues a sequential stream of the process and, if it does, put the next
+// pages in transit and reserve their frames. stops at the first page that is resident or in transit, at the
+// end of the process's pages, or when no frame can be taken now. returns the number of pages to read ahead.
+// the caller holds the pager lock
+int reserveReadahead(unsigned int threadNum, int pageIndex, ReadaheadPage *pages)
+{
+    ReadaheadState &state = readaheadStates[threadNum];
+    bool sequential = (pageIndex == state.expectedPage);
+    state.expectedPage = pageIndex + 1;
+    if (!sequential || readaheadMaxPages < READAHEAD_MIN_PAGES)
+        return 0;
+
+    // grow the window while the read ahead pages are used, shrink it when some of them were evicted unused
+    unsigned int wasted = state.wastedPages.load(memory_order_relaxed);
+    if (state.window == 0)
+        state.window = READAHEAD_MIN_PAGES;
+    else if (wasted != state.wastedSeen)
+        state.window = max(READAHEAD_MIN_PAGES, state.window / 2);
+    else
+        state.window = min(readaheadMaxPages, state.window * 2);
+    state.wastedSeen = wasted;
+
+    Statistics &stats = threadStats[threadNum].stats;
+    int endPage = (pageIndex / process_page_number + 1) * process_page_number; // first page of the next process
+    int count = 0;
+    for (int page = pageIndex + 1; page < endPage && count < state.window; page++)
+    {
+        {
+            unique_lock<mutex> pageGuard(pageLockOf(page).lock, defer_lock);
+            if (concurrentMode)
+                pageGuard.lock();
+            if (pageTable[page].valid() || pageTable[page].inTransit())
+                break;
+            pageTable.create(page).setInTransit(1);
+        }
+
+        ReadaheadPage &ahead = pages[count];
+        ahead.pageIndex = page;
+        ahead.victimPage = -1;
+        ahead.victimModified = false;
+        ahead.frameNumber = allocateFrame();
+        if (ahead.frameNumber == -1)
+        {
+            ahead.victimPage = chooseVictim(threadNum);
+            if (ahead.victimPage == -1)
+            {
+                finishTransit(page);
+                break;
+            }
+            ahead.frameNumber = evictPage(ahead.victimPage, ahead.victimModified);
+            if (ahead.victimModified)
+                gatherPageoutCluster(ahead.victimPage, ahead.frameNumber, ahead.cluster);
+            // a replacement, but not a miss: nobody accessed the page yet
+            stats.pageReplacements++;
+        }
+        assignFrame(ahead.frameNumber, threadNum, page);
+        count++;
+    }
+
+    stats.prefetchedPages += count;
+    state.expectedPage = pageIndex + 1 + count;
+    return count;
+}
+
+// non-blocking page-in (faultio=async). the disk reads of the faults are done by a pool of ioDepth I/O
+// threads, so up to ioDepth reads are outstanding at a time:
+// - a fault queues the read of its page and parks until an I/O thread has read it, then maps the page itself.
+//   its readahead is read meanwhile, and the other processes keep running on their resident pages
+// - a process that knows its next accesses calls startPageIn for their pages before it makes them.
+//   startPageIn reserves a frame for the page, writes the victim back and queues the read, then returns: the
+//   page stays in transit and the process keeps going. the I/O thread maps the page, and an access to the
+//   page waits only while it is still in transit.
+// ioMutex is a leaf lock
+struct PageIn
+{
+    int pageIndex;   // page that is read
+    int frameNumber; // frame reserved for it
+    bool *done;      // set when the page is read, for a parked fault that maps it. NULL: the I/O thread maps it
+};
+
+mutex ioMutex;                  // protects the I/O queue, ioStop and the done flags of the parked faults
+condition_variable ioWork;      // wakes an I/O thread when a page-in is queued or at shutdown
+condition_variable ioDone;      // wakes the parked faults when a page is read
+deque<PageIn> ioQueue;          // page-ins that no I/O thread has taken yet, oldest first
+bool ioStop = false;            // set at shutdown, the I/O threads exit when the queue is empty
+vector<thread> ioThreads;       // the I/O threads of faultio=async
+
+// I/O thread: read the oldest queued page. the page of a parked fault is handed back to it, a page that was
+// started ahead is mapped like a read ahead page, not referenced yet. the I/O thread does not touch the
+// statistics of the processes
+void ioThreadMain()
+{
+    unique_lock<mutex> ioGuard(ioMutex);
+    while (true)
+    {
+        while (ioQueue.empty() && !ioStop)
+            ioWork.wait(ioGuard);
+        if (ioQueue.empty())
+            return;
+        PageIn pageIn = ioQueue.front();
+        ioQueue.pop_front();
+        ioGuard.unlock();
+
+        struct iovec frame;
+        frame.iov_base = &physicalMemory[pageIn.frameNumber * globalFrameSize];
+        frame.iov_len = globalFrameSize * sizeof(int);
+        readDiskRun(&frame, 1, (off_t)pageIn.pageIndex * globalFrameSize * sizeof(int));
+        if (pageIn.done != NULL)
+        {
+            ioGuard.lock();
+            *pageIn.done = true;
+            ioDone.notify_all();
+            continue;
+        }
+
+        {
+            lock_guard<mutex> pagerGuard(pagerMutex);
+            PageLock &pageLock = pageLockOf(pageIn.pageIndex);
+            lock_guard<mutex> pageGuard(pageLock.lock);
+            PageTableEntry &entry = pageTable[pageIn.pageIndex];
+            entry.setFrameNumber(pageIn.frameNumber);
+            entry.setValid(1);
+            entry.setModified(0);
+            entry.setReferenced(0);
+            entry.setInTransit(0);
+            policyOf(pageIn.pageIndex)->onInsert(pageIn.pageIndex);
+            pageLock.transitDone.notify_all();
+        }
+        ioGuard.lock();
+    }
+}
+
+// true if the content of a page in transit is only in its disk slot, so bringing it in takes a disk read
+inline bool needsDiskRead(int pageIndex)
+{
+    return !mmapDisk && diskPageWritten[pageIndex].load(memory_order_relaxed) && !zswapContains(pageIndex);
+}
+
+// put the read of a page into its reserved frame on the I/O queue
+void queuePageIn(int pageIndex, int frameNumber, bool *done)
+{
+    {
+        lock_guard<mutex> ioGuard(ioMutex);
+        PageIn pageIn = {pageIndex, frameNumber, done};
+        ioQueue.push_back(pageIn);
+    }
+    ioWork.notify_one();
+}
+
+// park a fault until the I/O thread has read its page
+void waitPageIn(bool &done)
+{
+    unique_lock<mutex> ioGuard(ioMutex);
+    while (!done)
+        ioDone.wait(ioGuard);
+}
+
+// start reading the page of index of a process without waiting for it. returns false if nothing was started:
+// the page is resident or in transit, it has no disk read (never written, in the zswap pool or the disk is
+// mapped), or every frame is reserved. the access to the page then takes its fault as usual
+bool startPageIn(unsigned int threadNum, unsigned int index)
+{
+    int pageIndex = (threadNum - 1) * process_page_number + PageGeometry<RUNTIME_PAGE_SHIFT>::pageOf(index);
+    {
+        lock_guard<mutex> pageGuard(pageLockOf(pageIndex).lock);
+        if (pageTable[pageIndex].valid() || pageTable[pageIndex].inTransit())
+            return false;
+        pageTable.create(pageIndex).setInTransit(1);
+    }
+
+    // in transit the page can not be evicted into the pool or written to the disk, so this stays true
+    if (!needsDiskRead(pageIndex))
+    {
+        finishTransit(pageIndex);
+        return false;
+    }
+
+    Statistics &stats = threadStats[threadNum].stats;
+    unique_lock<mutex> pagerGuard(pagerMutex);
+    drainHits<ReplacementPolicy>(threadNum);
+    policyOf(pageIndex)->onMiss(pageIndex);
+    if (frameAllocation == ALLOCATION_PFF)
+        pffFault(threadNum);
+
+    int frameNumber = allocateFrame();
+    int victimPage = -1;
+    bool victimModified = false;
+    if (frameNumber == -1)
+    {
+        victimPage = chooseVictim(threadNum);
+        if (victimPage == -1)
+        {
+            pagerGuard.unlock();
+            finishTransit(pageIndex);
+            return false;
+        }
+        frameNumber = evictPage(victimPage, victimModified);
+        stats.pageReplacements++;
+        stats.pageMisses++;
+    }
+
+    PageoutCluster victimCluster;
+    if (victimModified)
+        gatherPageoutCluster(victimPage, frameNumber, victimCluster);
+    assignFrame(frameNumber, threadNum, pageIndex);
+    frameTable[frameNumber].diskIndex = pageIndex * globalFrameSize;
+    pagerGuard.unlock();
+
+    // the frame is read into after its victim is on the disk
+    if (victimModified)
+    {
+        writePageoutCluster(threadNum, victimCluster);
+        finishTransit(victimPage);
+    }
+
+    stats.diskPageReads++;
+    stats.asyncPageIns++;
+    queuePageIn(pageIndex, frameNumber, NULL);
+    return true;
+}
+
+// start the I/O threads of faultio=async
+void startFaultIO()
+{
+    ioQueue.clear();
+    ioStop = false;
+    for (int i = 0; i < ioDepth; i++)
+    {
+        ioThreads.push_back(thread(ioThreadMain));
+    }
+}
+
+// stop the I/O threads after they have read every queued page
+void stopFaultIO()
+{
+    {
+        lock_guard<mutex> ioGuard(ioMutex);
+        ioStop = true;
+    }
+    ioWork.notify_all();
+    for (size_t i = 0; i < ioThreads.size(); i++)
+    {
+        ioThreads[i].join();
+    }
+    ioThreads.clear();
+}
+
+// common path of get, set and the range functions. copies count integers of one page between the virtual
+// memory and buffer. every process has its own range of process_page_number pages in the page table, the
+// workers of a shared address space all use the range of process 1.
+// a page fault reserves a frame under the pager lock, then does the disk transfers without any lock, so
+// processes that fault on different pages do not wait for each other's disk I/O.
+template <int PageShift, class Policy>
+void accessPage(unsigned int threadNum, unsigned int index, int count, int *buffer, bool isWrite)
+{
+    Statistics &stats = threadStats[threadNum].stats;
+    if (traceFd != -1)
+        recordAccess(threadNum, index, count, isWrite);
+    // increase the read or write counter, once for every integer
+    if (isWrite)
+        stats.writes += count;
+    else
+        stats.reads += count;
+    if (telemetryEnabled)
+        telemetryAdd(telemetry[threadNum].accesses, count);
+    if (frameAllocation == ALLOCATION_WS && stats.reads + stats.writes - wsLastSample[threadNum] >= (unsigned int)WS_SAMPLE_ACCESSES)
+        sampleWorkingSet(threadNum);
+
+    int process = sharedAddressSpace ? 1 : threadNum;                                // process of the address space
+    int pageIndex = (process - 1) * process_page_number + PageGeometry<PageShift>::pageOf(index); // which page the index belongs to
+    int offset = PageGeometry<PageShift>::offsetOf(index);                                        // offset of the index in the page
+
+    PageLock &pageLock = pageLockOf(pageIndex);
+    unique_lock<mutex> pageGuard(pageLock.lock, defer_lock);
+    if (concurrentMode)
+        pageGuard.lock();
+
+    // TLB hit. the page is resident while its entry is in the TLB, the page table is not touched. the hit
+    // still advances the logical clock, the working set window of WSCL and the aging of AGING count every access
+    if (tlbEnabled)
+    {
+        unsigned long long entry;
+        int way = tlbLookup(threadNum, pageIndex, entry);
+        if (way != -1)
+        {
+            stats.tlbHits++;
+            accessTick.fetch_add(1, memory_order_relaxed);
+            copyFrameData<PageShift>(entry & 0x7FFFFFFF, offset, count, buffer, isWrite);
+            // first write through this entry sets the modified bit of the page
+            if (isWrite && !(entry & TLB_DIRTY_BIT))
+            {
+                markDirty(pageIndex);
+                tlbs[threadNum].entries[pageIndex % TLB_SETS][way].store(entry | TLB_DIRTY_BIT, memory_order_relaxed);
+            }
+            if (concurrentMode)
+                pageGuard.unlock();
+
+            touchRecentlyUsed<Policy>(threadNum, pageIndex);
+            countMemoryAccess(count);
+            return;
+        }
+        stats.tlbMisses++;
+    }
+
+    // logical time of this access
+    unsigned long long accessTime = ++accessTick;
+
+    // wait while the page is being moved between the disk and the physical memory
+    if (concurrentMode)
+    {
+        while (pageTable[pageIndex].inTransit())
+            pageLock.transitDone.wait(pageGuard);
+    }
+
+    if (pageTable[pageIndex].valid()) // check if the page is in the physical memory
+    {
+        // first access of a page that was read ahead
+        if (pageTable[pageIndex].prefetched())
+        {
+            pageTable[pageIndex].setPrefetched(0);
+            stats.prefetchHits++;
+        }
+        accessResidentPage<PageShift>(pageIndex, offset, count, buffer, isWrite, accessTime);
+        if (tlbEnabled)
+            tlbInsert(threadNum, pageIndex, pageTable[pageIndex].frameNumber(), pageTable[pageIndex].modified());
+        if (concurrentMode)
+            pageGuard.unlock();
+
+        touchRecentlyUsed<Policy>(threadNum, pageIndex);
+        countMemoryAccess(count);
+        return;
+    }
+
+    // page fault. the page stays in transit until it is mapped, other processes that need it wait
+    chrono::steady_clock::time_point faultStart;
+    if (telemetryEnabled)
+        faultStart = chrono::steady_clock::now();
+    pageTable.create(pageIndex).setInTransit(1);
+    if (concurrentMode)
+        pageGuard.unlock();
+
+    unique_lock<mutex> pagerGuard(pagerMutex, defer_lock);
+    if (concurrentMode)
+    {
+        pagerGuard.lock();
+        drainHits<Policy>(threadNum);
+    }
+
+    enginePolicyOf<Policy>(pageIndex)->onMiss(pageIndex);
+    if (frameAllocation == ALLOCATION_PFF)
+        pffFault(threadNum);
+
+    // take an empty frame from the free frame stack
+    int frameNumber = allocateFrame();
+    int victimPage = -1;
+    bool victimModified = false;
+
+    // no empty frame in the physical memory. Page replacement is needed
+    while (frameNumber == -1)
+    {
+        victimPage = chooseVictim(threadNum);
+        if (victimPage == -1)
+        {
+            // every frame is reserved by a fault in progress. let the other processes finish them. the guard
+            // only owns the pager lock in the concurrent mode
+            if (pagerGuard.owns_lock())
+                pagerGuard.unlock();
+            this_thread::yield();
+            if (concurrentMode)
+                pagerGuard.lock();
+            frameNumber = allocateFrame();
+            continue;
+        }
+
+        frameNumber = evictPage(victimPage, victimModified);
+        // increase the number of page replacements
+        stats.pageReplacements++;
+        // increase the number of page misses
+        stats.pageMisses++;
+    }
+
+    // the dirty neighbours of a modified victim are written with it
+    PageoutCluster victimCluster;
+    if (victimModified)
+        gatherPageoutCluster(victimPage, frameNumber, victimCluster);
+
+    // the frame is reserved for this page. it is not in the free stack or the replacement state until it is mapped
+    assignFrame(frameNumber, threadNum, pageIndex);
+
+    // the pages after a sequential fault are read with the same disk read
+    ReadaheadPage aheadPages[READAHEAD_MAX_PAGES];
+    int aheadCount = readaheadEnabled ? reserveReadahead(threadNum, pageIndex, aheadPages) : 0;
+    if (concurrentMode)
+        pagerGuard.unlock();
+
+    // ıf the victim page is modified, write it to the disk
+    if (victimModified)
+    {
+        writePageoutCluster(threadNum, victimCluster);
+        finishTransit(victimPage);
+    }
+    for (int i = 0; i < aheadCount; i++)
+    {
+        if (aheadPages[i].victimModified)
+        {
+            writePageoutCluster(threadNum, aheadPages[i].cluster);
+            finishTransit(aheadPages[i].victimPage);
+        }
+    }
+
+    // read the page from the disk to the physical memory. a write of the whole page does not need its old content.
+    // with faultio=async the disk read of the page goes to an I/O thread and the fault parks until it is done
+    int readFrames[READAHEAD_MAX_PAGES + 1];
+    int readCount = 0;
+    bool readDemandPage = !(isWrite && count == globalFrameSize);
+    bool parked = readDemandPage && asyncFaultIO && needsDiskRead(pageIndex);
+    bool pageRead = false;
+    if (parked)
+    {
+        frameTable[frameNumber].diskIndex = pageIndex * globalFrameSize;
+        stats.diskPageReads++;
+        stats.parkedPageIns++;
+        queuePageIn(pageIndex, frameNumber, &pageRead);
+        readDemandPage = false;
+    }
+    if (readDemandPage)
+        readFrames[readCount++] = frameNumber;
+    for (int i = 0; i < aheadCount; i++)
+        readFrames[readCount++] = aheadPages[i].frameNumber;
+    if (readCount > 0)
+        readPagesFromDisk(threadNum, readDemandPage ? pageIndex : pageIndex + 1, readFrames, readCount);
+    if (parked)
+        waitPageIn(pageRead);
+
+    if (concurrentMode)
+        pagerGuard.lock();
+
+    // map the read ahead pages. they are not referenced yet, so Clock takes them first if they stay unused
+    for (int i = aheadCount - 1; i >= 0; i--)
+    {
+        int page = aheadPages[i].pageIndex;
+        PageLock &aheadLock = pageLockOf(page);
+        unique_lock<mutex> aheadGuard(aheadLock.lock, defer_lock);
+        if (concurrentMode)
+            aheadGuard.lock();
+        pageTable[page].setFrameNumber(aheadPages[i].frameNumber);
+        pageTable[page].setValid(1);
+        pageTable[page].setModified(0);
+        pageTable[page].setReferenced(0);
+        pageTable[page].setPrefetched(1);
+        pageTable[page].setInTransit(0);
+        enginePolicyOf<Policy>(page)->onInsert(page);
+        if (concurrentMode)
+            aheadLock.transitDone.notify_all();
+    }
+
+    if (concurrentMode)
+        pageGuard.lock();
+
+    // update the page table entry
+    pageTable[pageIndex].setFrameNumber(frameNumber);
+    pageTable[pageIndex].setValid(1);
+    pageTable[pageIndex].setModified(0);
+    pageTable[pageIndex].setInTransit(0);
+    enginePolicyOf<Policy>(pageIndex)->onInsert(pageIndex);
+    accessResidentPage<PageShift>(pageIndex, offset, count, buffer, isWrite, accessTime);
+    if (tlbEnabled)
+        tlbInsert(threadNum, pageIndex, frameNumber, isWrite);
+
+    if (concurrentMode)
+    {
+        pageLock.transitDone.notify_all();
+        pageGuard.unlock();
+        pagerGuard.unlock();
+    }
+
+    if (telemetryEnabled)
+    {
+        TelemetryCounters &counters = telemetry[threadNum];
+        unsigned long long latency = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - faultStart).count();
+        int bucket = min(TELEMETRY_LATENCY_BUCKETS - 1, 63 - __builtin_clzll(latency | 1));
+        telemetryAdd(counters.faults, 1);
+        telemetryAdd(counters.faultLatency[bucket], 1);
+        counters.diskPageReads.store(stats.diskPageReads, memory_order_relaxed);
+        counters.diskPageWrites.store(stats.diskPageWrites, memory_order_relaxed);
+    }
+    countMemoryAccess(count);
+}
+
+// engine of the current simulation, set by initializeSimulation
+typedef void (*PagerEngine)(unsigned int threadNum, unsigned int index, int count, int *buffer, bool isWrite);
+PagerEngine pagerEngine = accessPage<RUNTIME_PAGE_SHIFT, ReplacementPolicy>;
+bool genericEngine = false; // engine=generic: every simulation runs the generic engine
+
+// engine of a policy for a log2 page size from PageShift up, the generic page size above ENGINE_MAX_PAGE_SHIFT
+template <class Policy, int PageShift>
+struct EngineOfPageShift
+{
+    static PagerEngine select(int pageShift)
+    {
+        return (pageShift == PageShift) ? accessPage<PageShift, Policy> : EngineOfPageShift<Policy, PageShift + 1>::select(pageShift);
+    }
+};
+
+template <class Policy>
+struct EngineOfPageShift<Policy, ENGINE_MAX_PAGE_SHIFT + 1>
+{
+    static PagerEngine select(int) { return accessPage<RUNTIME_PAGE_SHIFT, Policy>; }
+};
+
+// engine of a replacement policy name and a log2 page size
+PagerEngine selectPagerEngine(const string &replacement, int pageShift)
+{
+    if (genericEngine)
+        return accessPage<RUNTIME_PAGE_SHIFT, ReplacementPolicy>;
+    if (replacement == "LRU")
+        return EngineOfPageShift<LRUPolicy, 0>::select(pageShift);
+    if (replacement == "CL")
+        return EngineOfPageShift<ClockPolicy, 0>::select(pageShift);
+    if (replacement == "WSCL")
+        return EngineOfPageShift<WSClockPolicy, 0>::select(pageShift);
+    if (replacement == "LFU")
+        return EngineOfPageShift<LFUPolicy, 0>::select(pageShift);
+    if (replacement == "AGING")
+        return EngineOfPageShift<AgingPolicy, 0>::select(pageShift);
+    if (replacement == "2Q")
+        return EngineOfPageShift<TwoQueuePolicy, 0>::select(pageShift);
+    if (replacement == "ARC")
+        return EngineOfPageShift<ARCPolicy, 0>::select(pageShift);
+    return accessPage<RUNTIME_PAGE_SHIFT, ReplacementPolicy>;
+}
+
+// fence index of the array of a process: the first key of every page, in the memory of the program, not in the
+// simulated memory. set and setRange store the first integer of a page of the array when they write it, so the
+// index is complete once the array is filled and it is the index of the sorted array after the sort, without a
+// pass over the pages. in a sorted array x can only be in the last page whose first key is not larger than x
+struct FenceIndex
+{
+    vector<int> firstKeys; // first key of every page of the array
+};
+
+FenceIndex fenceIndexes[MAX_THREADS + 1]; // fence index of every process, indexed by thread number
+
+// store value in the fence index if index is the first integer of a page of the array
+inline void updateFenceIndex(unsigned int threadNum, unsigned int index, int value)
+{
+    // the page size is a power of two
+    if ((index & (globalFrameSize - 1)) != 0 || index / globalFrameSize >= (unsigned int)virtual_page_number)
+        return;
+    fenceIndexes[sharedAddressSpace ? 1 : threadNum].firstKeys[index / globalFrameSize] = value;
+}
+
+// set function to set the value of the data at the given index in the virtual memory
+void set(unsigned int threadNum, unsigned int index, int value)
+{
+    pagerEngine(threadNum, index, 1, &value, true);
+    updateFenceIndex(threadNum, index, value);
+}
+
+// get function to get the value of the data at the given index in the virtual memory
+int get(unsigned int threadNum, unsigned int index)
+{
+    int value;
+    pagerEngine(threadNum, index, 1, &value, false);
+    return value;
+}
+
+// copy count integers that start at index from the virtual memory to buffer. every page of the range is
+// looked up and faulted once, its integers are copied with one memcpy
+void getRange(unsigned int threadNum, unsigned int index, unsigned int count, int *buffer)
+{
+    while (count > 0)
+    {
+        unsigned int chunk = min(count, (unsigned int)(globalFrameSize - index % globalFrameSize)); // integers left in this page
+        pagerEngine(threadNum, index, chunk, buffer, false);
+        index += chunk;
+        buffer += chunk;
+        count -= chunk;
+    }
+}
+
+// copy count integers from buffer to the virtual memory, starting at index. page by page like getRange
+void setRange(unsigned int threadNum, unsigned int index, unsigned int count, const int *buffer)
+{
+    while (count > 0)
+    {
+        unsigned int chunk = min(count, (unsigned int)(globalFrameSize - index % globalFrameSize)); // integers left in this page
+        pagerEngine(threadNum, index, chunk, const_cast<int *>(buffer), true);
+        updateFenceIndex(threadNum, index, buffer[0]);
+        index += chunk;
+        buffer += chunk;
+        count -= chunk;
+    }
+}
+
+void merge(unsigned int threadNum, int left, int mid, int right)
+{
+    int n1 = mid - left + 1;
+    int n2 = right - mid;
+
+    // create temporary arrays
+    std::vector<int> L(n1);
+    std::vector<int> R(n2);
+
+    // Copy data to temporary arrays L[] and R[]
+    getRange(threadNum, left, n1, &L[0]);
+    getRange(threadNum, mid + 1, n2, &R[0]);
+
+    // Merge the temporary arrays into merged[], then write it back to arr[left..right] at once
+    std::vector<int> merged(n1 + n2);
+    int i = 0, j = 0;
+    int k = 0;
+
+    while (i < n1 && j < n2)
+    {
+        if (L[i] <= R[j])
+        {
+            merged[k] = L[i];
+            i++;
+        }
+        else
+        {
+            merged[k] = R[j];
+            j++;
+        }
+        k++;
+    }
+
+    // Copy the remaining elements of L[], if there are any
+    while (i < n1)
+    {
+        merged[k] = L[i];
+        i++;
+        k++;
+    }
+
+    while (j < n2)
+    {
+        merged[k] = R[j];
+        j++;
+        k++;
+    }
+
+    setRange(threadNum, left, n1 + n2, &merged[0]);
+}
+
+void mergeSort(unsigned int threadNum, int left, int right)
+{
+    if (left < right)
+    {
+        int mid = left + (right - left) / 2;
+
+        // sort the left half
+        mergeSort(threadNum, left, mid);
+
+        // sort the right half
+        mergeSort(threadNum, mid + 1, right);
+
+        // merge the sorted halves
+        merge(threadNum, left, mid, right);
+    }
+}
+
+// parallel merge sort. the workers of a shared address space sort the array of process 1 together. a range
+// larger than PARALLEL_SORT_GRAIN is split into halves: the worker keeps the left half and pushes the right half
+// on the back of its deque, idle workers steal from the front of the other deques, where the oldest and largest
+// ranges are. the worker that finishes the second half of a range merges it, so no worker waits for another
+#define PARALLEL_SORT_GRAIN 1024 // a range of at most this many integers is sorted by one worker with mergeSort
+
+// a range of the array that is sorted by the workers
+struct SortTask
+{
+    int left;
+    int right;
+    SortTask *parent;          // range that this range is a half of, NULL for the whole array
+    atomic<int> pendingHalves; // halves of the range that are not sorted yet
+
+    SortTask(int l, int r, SortTask *p) : left(l), right(r), parent(p), pendingHalves(0) {}
+};
+
+// task deque of one worker and its counters. only the worker itself changes its counters
+struct alignas(64) WorkerDeque
+{
+    mutex lock;
+    deque<SortTask *> tasks;
+    unsigned int tasksRun; // ranges the worker sorted or merged
+    unsigned int steals;   // ranges the worker took from the deque of another worker
+};
+
+WorkerDeque workerDeques[MAX_THREADS + 1]; // deque of every worker, indexed by thread number
+atomic<bool> parallelSortDone(false);      // the whole array is sorted, the workers exit
+
+// sort a range, splitting it down to the grain, then merge every range whose other half is already sorted
+void runSortTask(unsigned int threadNum, SortTask *task)
+{
+    WorkerDeque &own = workerDeques[threadNum];
+    while (task->right - task->left + 1 > PARALLEL_SORT_GRAIN)
+    {
+        int mid = task->left + (task->right - task->left) / 2;
+        task->pendingHalves.store(2, memory_order_relaxed);
+        SortTask *rightHalf = new SortTask(mid + 1, task->right, task);
+        {
+            lock_guard<mutex> dequeGuard(own.lock);
+            own.tasks.push_back(rightHalf);
+        }
+        task = new SortTask(task->left, mid, task);
+    }
+    mergeSort(threadNum, task->left, task->right);
+    own.tasksRun++;
+
+    // the halves wrote the array through the page locks, the counter orders them before the merge
+    for (SortTask *parent = task->parent; parent != NULL; parent = task->parent)
+    {
+        delete task;
+        if (parent->pendingHalves.fetch_sub(1, memory_order_acq_rel) != 1)
+            return;
+        merge(threadNum, parent->left, parent->left + (parent->right - parent->left) / 2, parent->right);
+        own.tasksRun++;
+        task = parent;
+    }
+    parallelSortDone.store(true, memory_order_release);
+}
+
+// take a range from the back of the own deque, or steal one from the front of another deque. NULL if all are empty
+SortTask *takeSortTask(unsigned int threadNum)
+{
+    WorkerDeque &own = workerDeques[threadNum];
+    {
+        lock_guard<mutex> dequeGuard(own.lock);
+        if (!own.tasks.empty())
+        {
+            SortTask *task = own.tasks.back();
+            own.tasks.pop_back();
+            return task;
+        }
+    }
+    for (int i = 1; i < numThreads; i++)
+    {
+        WorkerDeque &victim = workerDeques[(threadNum - 1 + i) % numThreads + 1];
+        lock_guard<mutex> dequeGuard(victim.lock);
+        if (!victim.tasks.empty())
+        {
+            SortTask *task = victim.tasks.front();
+            victim.tasks.pop_front();
+            own.steals++;
+            return task;
+        }
+    }
+    return NULL;
+}
+
+// work of one worker: run ranges until the whole array is sorted
+void parallelSortWorker(unsigned int threadNum)
+{
+    while (!parallelSortDone.load(memory_order_acquire))
+    {
+        SortTask *task = takeSortTask(threadNum);
+        if (task == NULL)
+            this_thread::yield();
+        else
+            runSortTask(threadNum, task);
+    }
+}
+
+// sort=parallel: sort the array of process 1 with numThreads workers. the calling thread is worker 1
+void parallelMergeSort()
+{
+    for (int t = 1; t <= numThreads; t++)
+    {
+        workerDeques[t].tasksRun = 0;
+        workerDeques[t].steals = 0;
+    }
+    parallelSortDone.store(false, memory_order_relaxed);
+    SortTask root(0, virtual_page_number * globalFrameSize - 1, NULL);
+    workerDeques[1].tasks.push_back(&root);
+
+    vector<thread> workers;
+    for (int t = 2; t <= numThreads; t++)
+    {
+        workers.push_back(thread(parallelSortWorker, t));
+    }
+    parallelSortWorker(1);
+    for (size_t t = 0; t < workers.size(); t++)
+    {
+        workers[t].join();
+    }
+}
+
+// print the ranges and the faults of every worker of the parallel merge sort
+void printWorkerTable()
+{
+    printf("┌──────────┬──────────┬──────────┬──────────────┬──────────────┐\n");
+    printf("│ Worker   │ Ranges   │ Steals   │ Page Misses  │ Disk Reads   │\n");
+    printf("├──────────┼──────────┼──────────┼──────────────┼──────────────┤\n");
+    for (int t = 1; t <= numThreads; t++)
+    {
+        const Statistics &stats = threadStats[t].stats;
+        printf("│ %8d │ %8u │ %8u │ %12u │ %12u │\n", t, workerDeques[t].tasksRun, workerDeques[t].steals, stats.pageMisses, stats.diskPageReads);
+    }
+    printf("└──────────┴──────────┴──────────┴──────────────┴──────────────┘\n");
+}
+
+// one input run of a k-way merge and its page sized buffer
+struct MergeRun
+{
+    unsigned int next;  // index of the next integer to read into the buffer
+    unsigned int end;   // index after the last integer of the run
+    vector<int> buffer; // one page of the run
+    unsigned int position; // next integer of the buffer to merge
+    unsigned int length;   // number of integers in the buffer
+};
+
+// load the next page of a run into its buffer. returns false when the run is used up
+bool loadMergeRun(unsigned int threadNum, MergeRun &run)
+{
+    if (run.next >= run.end)
+        return false;
+    run.length = min((unsigned int)globalFrameSize - run.next % globalFrameSize, run.end - run.next);
+    getRange(threadNum, run.next, run.length, &run.buffer[0]);
+    run.next += run.length;
+    run.position = 0;
+    return true;
+}
+
+// merge the sorted runs of runLength integers in [source + begin, source + end) into [target + begin, target + end).
+// every run is read one page at a time and the output is written one page at a time
+void mergeRuns(unsigned int threadNum, unsigned int source, unsigned int target, unsigned int begin, unsigned int end, unsigned int runLength)
+{
+    vector<MergeRun> runs;
+    // smallest head of the runs first: (value, run)
+    priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> heads;
+    for (unsigned int start = begin; start < end; start += min(runLength, end - start))
+    {
+        MergeRun run;
+        run.next = source + start;
+        run.end = source + min(end, start + runLength);
+        run.buffer.resize(globalFrameSize);
+        loadMergeRun(threadNum, run);
+        heads.push(make_pair(run.buffer[0], (int)runs.size()));
+        runs.push_back(run);
+    }
+
+    vector<int> output(globalFrameSize);
+    unsigned int outputIndex = target + begin; // index of output[0] in the virtual memory
+    unsigned int outputLength = 0;
+    while (!heads.empty())
+    {
+        int r = heads.top().second;
+        output[outputLength++] = heads.top().first;
+        heads.pop();
+
+        // the output page is full
+        if ((outputIndex + outputLength) % globalFrameSize == 0)
+        {
+            setRange(threadNum, outputIndex, outputLength, &output[0]);
+            outputIndex += outputLength;
+            outputLength = 0;
+        }
+
+        MergeRun &run = runs[r];
+        if (++run.position < run.length || loadMergeRun(threadNum, run))
+            heads.push(make_pair(run.buffer[run.position], r));
+    }
+    if (outputLength > 0)
+        setRange(threadNum, outputIndex, outputLength, &output[0]);
+}
+
+// page-aware external merge sort of the array of a process. phase 1 sorts runs that fit in the process's
+// share of the physical frames, phase 2 merges up to (frames - 1) runs at a time with one page per run.
+// the runs go back and forth between the array and the scratch pages after it, each pass reads and writes
+// every page once. the first pass is placed so that the last one ends in the array.
+void externalMergeSort(unsigned int threadNum)
+{
+    unsigned int size = virtual_page_number * globalFrameSize;           // integers in the array
+    unsigned int frames = max(2, physical_frame_number / numThreads);    // frames the process can expect to keep
+    unsigned int runLength = frames * globalFrameSize;                   // integers of a run of phase 1
+    unsigned int fanIn = max(2u, frames - 1);                            // runs merged at a time in phase 2
+
+    int mergePasses = 0;
+    for (unsigned long long length = runLength; length < size; length *= fanIn)
+        mergePasses++;
+    unsigned int scratch = size; // first index of the scratch pages
+    unsigned int source = (mergePasses % 2 == 0) ? 0 : scratch;
+
+    // phase 1: sort the runs in C++ memory
+    vector<int> run(min(runLength, size));
+    for (unsigned int start = 0; start < size; start += runLength)
+    {
+        unsigned int length = min(runLength, size - start);
+        getRange(threadNum, start, length, &run[0]);
+        sort(run.begin(), run.begin() + length);
+        setRange(threadNum, source + start, length, &run[0]);
+    }
+
+    // phase 2: k-way merge passes
+    for (unsigned long long length = runLength; length < size; length *= fanIn)
+    {
+        unsigned int target = (source == 0) ? scratch : 0;
+        unsigned long long groupLength = length * fanIn;
+        for (unsigned long long begin = 0; begin < size; begin += groupLength)
+            mergeRuns(threadNum, source, target, begin, min((unsigned long long)size, begin + groupLength), length);
+        source = target;
+    }
+
+    // the runs are in the array now. the scratch pages are dropped, their frames are free for the search
+    int firstScratchPage = (threadNum - 1) * process_page_number + virtual_page_number;
+    for (int page = firstScratchPage; page < firstScratchPage + virtual_page_number; page++)
+        releasePage(page);
+}
+
+void initializeDisk()
+{
+    // disk is a file. every integer of the disk is -1 at the start. the file is sparse: no slot is written, a
+    // page that was never written reads as -1 without a disk read (see readPagesFromDisk)
+    fd = open(disk_file_name.c_str(), O_RDWR | O_CREAT, 0666);
+    if (fd == -1)
+    {
+        cout << "Error: Cannot open disk file" << endl;
+        exit(1);
+    }
+    diskPageWritten = vector<atomic<unsigned char>>(disk_size / globalFrameSize);
+    initializeZswap();
+
+    // drop the content of a previous run, then give the file its size as a hole
+    size_t bytes = (size_t)disk_size * sizeof(int);
+    if (ftruncate(fd, 0) == -1 || ftruncate(fd, bytes) == -1)
+    {
+        cout << "Error: Cannot resize disk file" << endl;
+        exit(1);
+    }
+
+    // in mmap mode the pages move through a mapping of the whole file
+    if (mmapDisk)
+    {
+        void *mapping = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (mapping == MAP_FAILED)
+        {
+            cout << "Error: Cannot map disk file" << endl;
+            exit(1);
+        }
+        diskMapping = (int *)mapping;
+    }
+}
+
+// close the disk file. in mmap mode the mapping is written to the file first if msync is on, otherwise the
+// kernel writes it back whenever it wants
+void closeDisk()
+{
+    if (diskMapping != NULL)
+    {
+        size_t bytes = (size_t)disk_size * sizeof(int);
+        if (msyncDisk)
+            msync(diskMapping, bytes, MS_SYNC);
+        munmap(diskMapping, bytes);
+        diskMapping = NULL;
+    }
+    close(fd);
+}
+
+void printDisk()
+{
+    // print disk entries
+    int randomInt;
+    lseek(fd, 0, SEEK_SET);
+    for (int i = 0; i < disk_size; i++)
+    {
+        read(fd, &randomInt, sizeof(int));
+        if (!diskPageWritten[i / globalFrameSize].load(memory_order_relaxed))
+            randomInt = -1;
+
+        printf("Disk Entry %3d: %10d\n", i, randomInt);
+    }
+}
+
+int binarySearch(int threadNum, int l, int r, int x)
+{
+    while (l <= r)
+    {
+        // the rest of the search is inside one page. copy it with one range access and finish it here
+        if (l / globalFrameSize == r / globalFrameSize)
+        {
+            int base = l;
+            vector<int> window(r - l + 1);
+            getRange(threadNum, l, r - l + 1, &window[0]);
+            while (l <= r)
+            {
+                int m = l + (r - l) / 2;
+                int mid = window[m - base];
+                if (mid == x)
+                    return m;
+                if (mid < x)
+                    l = m + 1;
+                else
+                    r = m - 1;
+            }
+            return -1;
+        }
+
+        int m = l + (r - l) / 2;
+
+        int mid = get(threadNum, m); // get the value of the data at the given index in the virtual memory
+
+        if (mid == x)
             return m;
 
-        if (mid < x)
-            l = m + 1;
-        else
-            r = m - 1;
+        if (mid < x)
+            l = m + 1;
+        else
+            r = m - 1;
+    }
+
+    return -1;
+}
+
+// page of the array that can hold x, -1 if x is smaller than every key
+inline int fencePageOf(const vector<int> &firstKeys, int x)
+{
+    return (int)(upper_bound(firstKeys.begin(), firstKeys.end(), x) - firstKeys.begin()) - 1;
+}
+
+// index of x in a page that was copied to window, -1 if it is not there
+inline int searchPageWindow(const vector<int> &window, int page, int x)
+{
+    vector<int>::const_iterator found = lower_bound(window.begin(), window.end(), x);
+    if (found == window.end() || *found != x)
+        return -1;
+    return page * globalFrameSize + (int)(found - window.begin());
+}
+
+// find x with the fence index. touches at most one page of the array, none if x is the first key of a page
+int fenceSearch(unsigned int threadNum, int x)
+{
+    const vector<int> &firstKeys = fenceIndexes[threadNum].firstKeys;
+    int page = fencePageOf(firstKeys, x);
+    if (page == -1)
+        return -1;
+    if (firstKeys[page] == x)
+        return page * globalFrameSize;
+
+    vector<int> window(globalFrameSize);
+    getRange(threadNum, page * globalFrameSize, globalFrameSize, &window[0]);
+    return searchPageWindow(window, page, x);
+}
+
+// find every key of keys with the fence index and put its index, or -1, in results. the keys are searched in
+// ascending order, so the lookups stream through the pages in order and every page is touched once
+void batchSearch(unsigned int threadNum, const vector<int> &keys, int *results)
+{
+    const vector<int> &firstKeys = fenceIndexes[threadNum].firstKeys;
+    vector<int> order(keys.size());
+    for (size_t i = 0; i < keys.size(); i++)
+    {
+        order[i] = (int)i;
+    }
+    sort(order.begin(), order.end(), [&keys](int a, int b) { return keys[a] < keys[b]; });
+
+    vector<int> window(globalFrameSize);
+    int windowPage = -1; // page that is in window, -1 before the first copy
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        int x = keys[order[i]];
+        int page = fencePageOf(firstKeys, x);
+        if (page == -1)
+            results[order[i]] = -1;
+        else if (firstKeys[page] == x)
+            results[order[i]] = page * globalFrameSize;
+        else
+        {
+            if (page != windowPage)
+            {
+                getRange(threadNum, page * globalFrameSize, globalFrameSize, &window[0]);
+                windowPage = page;
+            }
+            results[order[i]] = searchPageWindow(window, page, x);
+        }
+    }
+}
+// merge the statistics of every process into statsOfProgram. physical frames in memory of a process is
+// the number of frames it owns at the end of the run, of the program the frames that are not free
+void mergeStatistics()
+{
+    for (int t = 1; t <= numThreads; t++)
+    {
+        threadStats[t].stats.physicalFramesInMemory = 0;
+    }
+    for (int f = 0; f < physical_frame_number; f++)
+    {
+        if (frameTable[f].threadNum > 0)
+            threadStats[frameTable[f].threadNum].stats.physicalFramesInMemory++;
+    }
+    // evictions of every process count the wasted prefetches of the owner, the flusher its background writes
+    for (int t = 1; t <= numThreads; t++)
+    {
+        threadStats[t].stats.wastedPrefetches = readaheadStates[t].wastedPages;
+        threadStats[t].stats.backgroundPageWrites = backgroundPageWrites[t].load(memory_order_relaxed);
+    }
+
+    statsOfProgram = Statistics();
+    for (int t = 1; t <= numThreads; t++)
+    {
+        const Statistics &stats = threadStats[t].stats;
+        statsOfProgram.reads += stats.reads;
+        statsOfProgram.writes += stats.writes;
+        statsOfProgram.pageMisses += stats.pageMisses;
+        statsOfProgram.pageReplacements += stats.pageReplacements;
+        statsOfProgram.diskPageWrites += stats.diskPageWrites;
+        statsOfProgram.diskPageReads += stats.diskPageReads;
+        statsOfProgram.tlbHits += stats.tlbHits;
+        statsOfProgram.tlbMisses += stats.tlbMisses;
+        statsOfProgram.backgroundPageWrites += stats.backgroundPageWrites;
+        statsOfProgram.diskWriteOperations += stats.diskWriteOperations;
+        statsOfProgram.asyncPageIns += stats.asyncPageIns;
+        statsOfProgram.parkedPageIns += stats.parkedPageIns;
+        statsOfProgram.firstTouchPages += stats.firstTouchPages;
+        statsOfProgram.zswapStores += stats.zswapStores;
+        statsOfProgram.zswapLoads += stats.zswapLoads;
+        statsOfProgram.zswapWritebacks += stats.zswapWritebacks;
+        statsOfProgram.zswapRejects += stats.zswapRejects;
+        statsOfProgram.zswapStoredBytes += stats.zswapStoredBytes;
+        statsOfProgram.zswapCompressedBytes += stats.zswapCompressedBytes;
+        statsOfProgram.prefetchedPages += stats.prefetchedPages;
+        statsOfProgram.prefetchHits += stats.prefetchHits;
+        statsOfProgram.wastedPrefetches += stats.wastedPrefetches;
+        statsOfProgram.physicalFramesInMemory += stats.physicalFramesInMemory;
+    }
+}
+
+// statistics of a process from the time of before to the time of now, e.g. of its search phase
+Statistics statisticsSince(const Statistics &before, const Statistics &now)
+{
+    Statistics since = now;
+    since.reads -= before.reads;
+    since.writes -= before.writes;
+    since.pageMisses -= before.pageMisses;
+    since.pageReplacements -= before.pageReplacements;
+    since.diskPageWrites -= before.diskPageWrites;
+    since.diskPageReads -= before.diskPageReads;
+    since.tlbHits -= before.tlbHits;
+    since.tlbMisses -= before.tlbMisses;
+    since.backgroundPageWrites -= before.backgroundPageWrites;
+    since.prefetchedPages -= before.prefetchedPages;
+    since.prefetchHits -= before.prefetchHits;
+    since.diskWriteOperations -= before.diskWriteOperations;
+    since.asyncPageIns -= before.asyncPageIns;
+    since.parkedPageIns -= before.parkedPageIns;
+    since.firstTouchPages -= before.firstTouchPages;
+    since.zswapStores -= before.zswapStores;
+    since.zswapLoads -= before.zswapLoads;
+    since.zswapWritebacks -= before.zswapWritebacks;
+    since.zswapRejects -= before.zswapRejects;
+    since.zswapStoredBytes -= before.zswapStoredBytes;
+    since.zswapCompressedBytes -= before.zswapCompressedBytes;
+    return since;
+}
+
+// physical memory.  threads share the same physical memory.
+
+// set up the page table, physical memory and disk for one simulation. sizes are given as powers of two like on the command line.
+// scratchPages virtual pages are added after the array of every process
+void initializeSimulation(int frameSize, int numPhysical, int numVirtual, const string &replacement, unsigned int printInterval, const string &diskFileName, int threadCount, int scratchPages = 0)
+{
+    // numVirtual = (2^numVirtual)
+    numVirtual = pow(2, numVirtual);
+    int pageShift = frameSize;
+    frameSize = pow(2, frameSize);
+    numPhysical = pow(2, numPhysical);
+
+    // physical_memory_size = (2^frameSize)* (2^numPhysical)
+    physical_memory_size = frameSize * numPhysical;
+    physical_frame_number = numPhysical;
+    virtual_page_number = numVirtual;
+    process_page_number = numVirtual + scratchPages;
+    numThreads = threadCount;
+    concurrentMode = (numThreads > 1 || backgroundWriteback || asyncFaultIO); // the flusher and the I/O threads run next to the processes
+    int processes = sharedAddressSpace ? 1 : numThreads;      // address spaces of process_page_number pages
+    if (numThreads < 1 || numThreads > MAX_THREADS || !simulationFits(frameSize, process_page_number, processes, numPhysical))
+    {
+        cout << "Error: " << numThreads << " processes of " << process_page_number << " virtual pages do not fit in the page table" << endl;
+        exit(1);
+    }
+    page_table_size = process_page_number * processes;
+    disk_size = process_page_number * frameSize * max(2, processes);
+    disk_file_name = diskFileName;
+    globalFrameSize = frameSize;
+    pageReplacement = replacement;
+    pageTablePrintInt = printInterval;
+    delete policy;
+    policy = createPolicy(pageReplacement);
+    if (policy == NULL)
+    {
+        cout << "Error: unknown page replacement " << pageReplacement << ", use LRU, CL, WSCL, LFU, AGING, 2Q or ARC" << endl;
+        exit(1);
+    }
+    pagerEngine = selectPagerEngine(pageReplacement, pageShift);
+    // quotas and the policies of the processes under local replacement
+    initializeFrameAllocation();
+
+    // reset the counters of a previous simulation
+    for (int t = 0; t <= MAX_THREADS; t++)
+    {
+        threadStats[t].stats = Statistics();
+        backgroundPageWrites[t].store(0, memory_order_relaxed);
+        hitBuffers[t].count = 0;
+    }
+    statsOfProgram = Statistics();
+    statsOfProgram.physicalFramesInMemory = numPhysical;
+    memoryAccessCounter = 0;
+    accessTick = 0;
+
+    // the fence indexes are filled by the writes of the arrays
+    for (int t = 1; t <= numThreads; t++)
+    {
+        fenceIndexes[t].firstKeys.assign(virtual_page_number, 0);
+    }
+
+    // init page table
+    initializePageTable();
+    // empty the TLBs
+    initializeTLBs();
+    // forget the sequential streams
+    initializeReadahead();
+    // init physical memory
+    initializePhysicalMemory();
+
+    // print physical memory
+    // printPhysicalMemory();
+
+    // init disk
+    initializeDisk();
+}
+
+//_______________________________________________________________________________________________________________________
+// PROGRAMS
+
+// search 5 numbers (2 of them not in the array)
+#define SEARCH_COUNT 5
+int searchNumbers[SEARCH_COUNT] = {994, 966, 899, 110, 290};
+bool externalSort = false; // sort=external: sort with externalMergeSort instead of mergeSort
+
+// how the sorted array is searched, selected with search=binary|fence|batch
+enum SearchMode
+{
+    SEARCH_BINARY, // binarySearch through the simulated memory, every probe can fault
+    SEARCH_FENCE,  // fenceSearch of one key after the other, one page per lookup
+    SEARCH_BATCH   // batchSearch of all keys in ascending order, every page once
+};
+SearchMode searchMode = SEARCH_BINARY;
+vector<int> searchKeys(searchNumbers, searchNumbers + SEARCH_COUNT); // searchNumbers, then searches=N random keys
+Statistics searchStats[MAX_THREADS + 1]; // statistics of the search phase of every process
+
+// optional name=value arguments of a program, e.g. sort=external
+map<string, string> parseOptions(int argc, char *argv[], int first)
+{
+    map<string, string> options;
+    for (int i = first; i < argc; i++)
+    {
+        string argument = argv[i];
+        size_t equals = argument.find('=');
+        if (equals == string::npos)
+        {
+            cout << "Error: option " << argument << " is not of the form name=value" << endl;
+            exit(1);
+        }
+        options[argument.substr(0, equals)] = argument.substr(equals + 1);
+    }
+    return options;
+}
+
+// value of an option, or defaultValue when it is not given
+string optionValue(const map<string, string> &options, const string &name, const string &defaultValue)
+{
+    map<string, string>::const_iterator it = options.find(name);
+    return (it == options.end()) ? defaultValue : it->second;
+}
+
+// list of integers of a sweep argument: comma separated values and ranges, e.g. "2,4,6" or "4-8"
+vector<int> parseIntList(const string &text)
+{
+    vector<int> values;
+    size_t begin = 0;
+    while (begin < text.size())
+    {
+        size_t end = text.find(',', begin);
+        if (end == string::npos)
+            end = text.size();
+        string item = text.substr(begin, end - begin);
+        size_t dash = item.find('-', 1);
+        int first = stoi(item.substr(0, dash));
+        int last = (dash == string::npos) ? first : stoi(item.substr(dash + 1));
+        for (int value = first; value <= last; value++)
+            values.push_back(value);
+        begin = end + 1;
+    }
+    return values;
+}
+
+// comma separated names of a sweep argument or an option
+vector<string> parseNameList(const string &text)
+{
+    vector<string> names;
+    size_t begin = 0;
+    while (begin < text.size())
+    {
+        size_t end = text.find(',', begin);
+        if (end == string::npos)
+            end = text.size();
+        names.push_back(text.substr(begin, end - begin));
+        begin = end + 1;
+    }
+    return names;
+}
+
+// disk=file|mmap and msync=off|on select the backing store of the disk. returns false for an unknown value
+bool applyDiskOptions(const map<string, string> &options)
+{
+    string disk = optionValue(options, "disk", "file");
+    string sync = optionValue(options, "msync", "off");
+    if ((disk != "file" && disk != "mmap") || (sync != "off" && sync != "on"))
+    {
+        cout << "Error: unknown disk " << disk << " or msync " << sync << ", use disk=file|mmap and msync=off|on" << endl;
+        return false;
+    }
+    mmapDisk = (disk == "mmap");
+    msyncDisk = (sync == "on");
+    return true;
+}
+
+// pagetable=flat|radix|inverted selects the organisation of the page table. returns false for an unknown value
+bool applyPageTableOption(const map<string, string> &options)
+{
+    string table = optionValue(options, "pagetable", "flat");
+    if (table != "flat" && table != "radix" && table != "inverted")
+    {
+        cout << "Error: unknown pagetable " << table << ", use flat, radix or inverted" << endl;
+        return false;
+    }
+    pageTableMode = (table == "flat") ? PAGE_TABLE_FLAT : (table == "radix") ? PAGE_TABLE_RADIX : PAGE_TABLE_INVERTED;
+    return true;
+}
+
+// allocation=global|fixed|pff|ws selects global or local replacement and the frame quotas. returns false for an unknown value
+bool applyAllocationOption(const map<string, string> &options)
+{
+    string allocation = optionValue(options, "allocation", "global");
+    for (int mode = ALLOCATION_GLOBAL; mode <= ALLOCATION_WS; mode++)
+    {
+        if (allocation == allocationNames[mode])
+        {
+            frameAllocation = (FrameAllocation)mode;
+            return true;
+        }
+    }
+    cout << "Error: unknown allocation " << allocation << ", use global, fixed, pff or ws" << endl;
+    return false;
+}
+
+// faultio=sync|async, iodepth=N and disklatency=N select how the faults read the disk. returns false for a bad value
+bool applyFaultIOOptions(const map<string, string> &options)
+{
+    string faultIO = optionValue(options, "faultio", "sync");
+    ioDepth = stoi(optionValue(options, "iodepth", "4"));
+    diskReadLatencyUs = stoi(optionValue(options, "disklatency", "0"));
+    if ((faultIO != "sync" && faultIO != "async") || ioDepth < 1 || ioDepth > MAX_THREADS || diskReadLatencyUs < 0)
+    {
+        cout << "Error: use faultio=sync|async, iodepth=1.." << MAX_THREADS << " and disklatency >= 0" << endl;
+        return false;
+    }
+    asyncFaultIO = (faultIO == "async");
+    return true;
+}
+
+// synthetic workloads, selected with workload=uniform|zipf|loop|scan|phased instead of the sort. every process
+// fills its array like sortArrays and then makes accesses=N accesses to it, writes=P percent of them writes.
+// the generators give the page of every access, the offset in the page is random except for scan:
+//   uniform  every page of the array with the same probability
+//   zipf     the page of rank k with a probability proportional to 1 / k^theta, zipf=0.99. an odd multiplier
+//            spreads the ranks over the array, so the hot pages are not neighbours
+//   loop     pages 0 to loop=N - 1 again and again. by default an eighth more pages than the frames of a
+//            process, the worst case of LRU: every access misses
+//   scan     every integer of the array in order, again and again
+//   phased   the generators of phases=uniform,zipf,loop,scan in turn, phase=N accesses each
+enum WorkloadKind
+{
+    WORKLOAD_SORT,
+    WORKLOAD_UNIFORM,
+    WORKLOAD_ZIPF,
+    WORKLOAD_LOOP,
+    WORKLOAD_SCAN,
+    WORKLOAD_PHASED
+};
+const char *workloadNames[] = {"sort", "uniform", "zipf", "loop", "scan", "phased"}; // option values, in the order of WorkloadKind
+
+struct WorkloadConfig
+{
+    WorkloadKind kind;
+    unsigned int accesses;       // accesses of every process after the fill
+    int writePercent;            // percent of the accesses that are writes
+    double zipfTheta;            // skew of the zipf generator
+    int loopPages;               // pages of the loop, 0 for an eighth more than the frames of a process
+    unsigned int phaseAccesses;  // accesses of one phase of the phased workload
+    vector<WorkloadKind> phases; // generators of the phased workload, in order
+};
+WorkloadConfig workload = {WORKLOAD_SORT, 1000000, 25, 0.99, 0, 100000, {WORKLOAD_UNIFORM, WORKLOAD_ZIPF, WORKLOAD_LOOP, WORKLOAD_SCAN}};
+
+vector<double> zipfDistribution;         // probability of the ranks up to and including rank k, for zipf
+Statistics workloadStats[MAX_THREADS + 1]; // statistics of the accesses of every process after its fill
+
+// workload kind of an option value, -1 for an unknown one
+int workloadKindOf(const string &name)
+{
+    for (int kind = WORKLOAD_SORT; kind <= WORKLOAD_PHASED; kind++)
+    {
+        if (name == workloadNames[kind])
+            return kind;
+    }
+    return -1;
+}
+
+// workload=, accesses=, writes=, zipf=, loop=, phase= and phases= select the workload. returns false for a bad value
+bool applyWorkloadOptions(const map<string, string> &options)
+{
+    int kind = workloadKindOf(optionValue(options, "workload", "sort"));
+    if (kind == -1)
+    {
+        cout << "Error: unknown workload " << optionValue(options, "workload", "") << ", use sort, uniform, zipf, loop, scan or phased" << endl;
+        return false;
+    }
+    workload.kind = (WorkloadKind)kind;
+    workload.accesses = stoul(optionValue(options, "accesses", "1000000"));
+    workload.writePercent = stoi(optionValue(options, "writes", "25"));
+    workload.zipfTheta = stod(optionValue(options, "zipf", "0.99"));
+    workload.loopPages = stoi(optionValue(options, "loop", "0"));
+    workload.phaseAccesses = stoul(optionValue(options, "phase", "100000"));
+    if (workload.writePercent < 0 || workload.writePercent > 100 || workload.zipfTheta <= 0 || workload.loopPages < 0 || workload.phaseAccesses < 1)
+    {
+        cout << "Error: use writes=0..100, zipf > 0, loop >= 0 and phase > 0" << endl;
+        return false;
+    }
+    vector<string> phases = parseNameList(optionValue(options, "phases", "uniform,zipf,loop,scan"));
+    workload.phases.clear();
+    for (size_t i = 0; i < phases.size(); i++)
+    {
+        int phase = workloadKindOf(phases[i]);
+        if (phase <= WORKLOAD_SORT || phase == WORKLOAD_PHASED)
+        {
+            cout << "Error: unknown phase " << phases[i] << ", use uniform, zipf, loop or scan" << endl;
+            return false;
+        }
+        workload.phases.push_back((WorkloadKind)phase);
+    }
+    return !workload.phases.empty();
+}
+
+// probabilities of the zipf ranks for the pages of the current simulation
+void initializeZipf()
+{
+    zipfDistribution.resize(virtual_page_number);
+    double sum = 0;
+    for (int rank = 0; rank < virtual_page_number; rank++)
+    {
+        sum += 1.0 / pow(rank + 1, workload.zipfTheta);
+        zipfDistribution[rank] = sum;
+    }
+    for (int rank = 0; rank < virtual_page_number; rank++)
+    {
+        zipfDistribution[rank] /= sum;
+    }
+}
+
+// virtual memory index of the next access of a generator. step is the number of its accesses before this one
+unsigned int nextWorkloadIndex(WorkloadKind kind, struct random_data &randomData, unsigned int step)
+{
+    int32_t randomNumber;
+    random_r(&randomData, &randomNumber);
+    unsigned int offset = randomNumber % globalFrameSize;
+    unsigned int page;
+    switch (kind)
+    {
+    case WORKLOAD_ZIPF:
+    {
+        double u = (double)randomNumber / 2147483648.0;
+        unsigned int rank = min((int)(upper_bound(zipfDistribution.begin(), zipfDistribution.end(), u) - zipfDistribution.begin()), virtual_page_number - 1);
+        // the number of pages is a power of two, so an odd multiplier maps the ranks to different pages
+        page = (rank * 2654435761u) & (virtual_page_number - 1);
+        break;
+    }
+    case WORKLOAD_LOOP:
+    {
+        int loopPages = workload.loopPages;
+        if (loopPages == 0)
+        {
+            int frames = max(1, physical_frame_number / numThreads);
+            loopPages = frames + max(1, frames / 8);
+        }
+        page = step % min(loopPages, virtual_page_number);
+        break;
+    }
+    case WORKLOAD_SCAN:
+        return step % (virtual_page_number * globalFrameSize);
+    default:
+        page = (randomNumber / globalFrameSize) % virtual_page_number;
+        break;
+    }
+    return page * globalFrameSize + offset;
+}
+
+// one access of a workload
+struct WorkloadAccess
+{
+    unsigned int index; // virtual memory index
+    bool isWrite;       // set, or get
+    int value;          // value of a set
+};
+
+// the accesses of the workload of one process, in order. the random state is seeded with the thread number, so
+// a process makes the same accesses in every run
+struct WorkloadStream
+{
+    char randomState[128];
+    struct random_data randomData;
+    size_t phase;      // current phase of the phased workload
+    unsigned int step; // accesses of the current phase
+
+    WorkloadStream(unsigned int threadNum) : randomData(), phase(0), step(0)
+    {
+        initstate_r(7919 * threadNum, randomState, sizeof(randomState), &randomData);
+    }
+
+    WorkloadAccess next()
+    {
+        WorkloadKind kind = workload.kind;
+        if (kind == WORKLOAD_PHASED)
+        {
+            if (step == workload.phaseAccesses)
+            {
+                phase = (phase + 1) % workload.phases.size();
+                step = 0;
+            }
+            kind = workload.phases[phase];
+        }
+        WorkloadAccess access;
+        access.index = nextWorkloadIndex(kind, randomData, step++);
+
+        int32_t randomNumber;
+        random_r(&randomData, &randomNumber);
+        access.isWrite = (randomNumber % 100 < workload.writePercent);
+        access.value = randomNumber % 1000;
+        return access;
+    }
+};
+
+// work of one simulated process: fill its array and make the accesses of the workload to it. with faultio=async
+// the accesses are generated ioDepth ahead of the one that is made, and the page-ins of their pages are started
+// then, so up to ioDepth disk reads of the process are outstanding while it works on its resident pages
+void workloadProcess(unsigned int threadNum)
+{
+    fillVirtualMemory(threadNum);
+    Statistics before = threadStats[threadNum].stats;
+
+    WorkloadStream stream(threadNum);
+    int window = asyncFaultIO ? ioDepth : 0;  // accesses generated ahead of the current one
+    vector<WorkloadAccess> ahead(window + 1); // ring of the generated accesses
+    unsigned int generated = 0;
+    for (unsigned int i = 0; i < workload.accesses; i++)
+    {
+        while (generated < workload.accesses && generated <= i + window)
+        {
+            WorkloadAccess &access = ahead[generated % ahead.size()];
+            access = stream.next();
+            if (window > 0)
+                startPageIn(threadNum, access.index);
+            generated++;
+        }
+
+        const WorkloadAccess &access = ahead[i % ahead.size()];
+        if (access.isWrite)
+            set(threadNum, access.index, access.value);
+        else
+            get(threadNum, access.index);
+    }
+
+    workloadStats[threadNum] = statisticsSince(before, threadStats[threadNum].stats);
+}
+
+// run workloadProcess for every simulated process. a single process runs on the calling thread
+void runWorkloads()
+{
+    if (workload.kind == WORKLOAD_ZIPF || workload.kind == WORKLOAD_PHASED)
+        initializeZipf();
+    if (numThreads == 1)
+    {
+        workloadProcess(1);
+        return;
+    }
+
+    vector<thread> processes;
+    for (int t = 1; t <= numThreads; t++)
+    {
+        processes.push_back(thread(workloadProcess, t));
+    }
+    for (size_t t = 0; t < processes.size(); t++)
+    {
+        processes[t].join();
+    }
+}
+
+// print the accesses of the workload of every process together, without the fill
+void printWorkloadStatistics()
+{
+    Statistics total = Statistics();
+    for (int t = 1; t <= numThreads; t++)
+    {
+        const Statistics &stats = workloadStats[t];
+        total.reads += stats.reads;
+        total.writes += stats.writes;
+        total.pageMisses += stats.pageMisses;
+        total.diskPageReads += stats.diskPageReads;
+        total.diskPageWrites += stats.diskPageWrites;
+        total.tlbMisses += stats.tlbMisses;
+    }
+    unsigned int accesses = total.reads + total.writes;
+
+    printf("┌───────────────────────────────┬────────────┐\n");
+    printf("│ Workload                      │ %10s │\n", workloadNames[workload.kind]);
+    printf("├───────────────────────────────┼────────────┤\n");
+    printf("│ Accesses                      │ %10u │\n", accesses);
+    printf("│ Writes                        │ %10u │\n", total.writes);
+    printf("│ Page Misses                   │ %10u │\n", total.pageMisses);
+    printf("│ Disk Page Reads               │ %10u │\n", total.diskPageReads);
+    printf("│ Disk Page Writes              │ %10u │\n", total.diskPageWrites);
+    printf("│ TLB Misses                    │ %10u │\n", total.tlbMisses);
+    printf("│ Misses Per 1000 Accesses      │ %10.2f │\n", accesses ? 1000.0 * total.pageMisses / accesses : 0.0);
+    printf("└───────────────────────────────┴────────────┘\n");
+}
+
+// work of one simulated process: fill, sort and search its own virtual memory
+void sortArraysProcess(unsigned int threadNum, int *searchResults)
+{
+    fillVirtualMemory(threadNum);
+
+    // print physical memory
+    // printPhysicalMemory();
+
+    // print disk
+    // printDisk();
+
+    // merge sort
+    if (externalSort)
+        externalMergeSort(threadNum);
+    else if (sharedAddressSpace)
+        parallelMergeSort();
+    else
+        mergeSort(threadNum, 0, (virtual_page_number * globalFrameSize) - 1);
+
+    // search every key
+    Statistics before = threadStats[threadNum].stats;
+    if (searchMode == SEARCH_BATCH)
+    {
+        batchSearch(threadNum, searchKeys, searchResults);
+    }
+    else
+    {
+        for (size_t i = 0; i < searchKeys.size(); i++)
+        {
+            if (searchMode == SEARCH_FENCE)
+                searchResults[i] = fenceSearch(threadNum, searchKeys[i]);
+            else
+                searchResults[i] = binarySearch(threadNum, 0, virtual_page_number * globalFrameSize - 1, searchKeys[i]);
+        }
+    }
+    searchStats[threadNum] = statisticsSince(before, threadStats[threadNum].stats);
+}
+
+// run sortArraysProcess for every simulated process. a single process runs on the calling thread, and so does
+// the process of the parallel merge sort, which starts its other workers itself
+void runSortArrays(vector<vector<int>> &searchResults)
+{
+    searchResults.assign(numThreads + 1, vector<int>(searchKeys.size()));
+    if (numThreads == 1 || sharedAddressSpace)
+    {
+        sortArraysProcess(1, &searchResults[1][0]);
+        return;
+    }
+
+    vector<thread> processes;
+    for (int t = 1; t <= numThreads; t++)
+    {
+        processes.push_back(thread(sortArraysProcess, t, &searchResults[t][0]));
+    }
+    for (size_t t = 0; t < processes.size(); t++)
+    {
+        processes[t].join();
+    }
+}
+
+// print the cost of the search phase of every process together: the found keys and the accesses, misses and
+// disk reads of the searches
+void printSearchStatistics(const vector<vector<int>> &searchResults, int processes)
+{
+    Statistics total = Statistics();
+    unsigned int found = 0;
+    for (int t = 1; t <= processes; t++)
+    {
+        total.reads += searchStats[t].reads;
+        total.pageMisses += searchStats[t].pageMisses;
+        total.diskPageReads += searchStats[t].diskPageReads;
+        total.tlbMisses += searchStats[t].tlbMisses;
+        for (size_t i = 0; i < searchKeys.size(); i++)
+        {
+            found += (searchResults[t][i] != -1);
+        }
+    }
+    unsigned int searches = searchKeys.size() * processes;
+    const char *modes[] = {"binary", "fence", "batch"};
+
+    printf("┌───────────────────────────────┬────────────┐\n");
+    printf("│ Search Phase                  │ Value      │\n");
+    printf("├───────────────────────────────┼────────────┤\n");
+    printf("│ Search                        │ %10s │\n", modes[searchMode]);
+    printf("│ Searches                      │ %10u │\n", searches);
+    printf("│ Found                         │ %10u │\n", found);
+    printf("│ Reads                         │ %10u │\n", total.reads);
+    printf("│ Page Misses                   │ %10u │\n", total.pageMisses);
+    printf("│ Disk Page Reads               │ %10u │\n", total.diskPageReads);
+    printf("│ TLB Misses                    │ %10u │\n", total.tlbMisses);
+    printf("│ Disk Page Reads Per Search    │ %10.3f │\n", (double)total.diskPageReads / searches);
+    printf("└───────────────────────────────┴────────────┘\n");
+}
+
+// sortArrays: fill, sort and search the virtual memory of every thread
+int sort_arrays_program(int argc, char *argv[])
+{
+
+    if (argc < 7)
+    {
+        cout << "Usage: sortArrays frameSize numPhysical numVirtual pageReplacement pageTablePrintInt diskFileName.dat [numThreads] [sort=merge|external|parallel] [writeback=sync|background] [readahead=off|on] [disk=file|mmap] [msync=off|on] [trace=file] [pagetable=flat|radix|inverted] [allocation=global|fixed|pff|ws] [cluster=1] [zswap=0] [dump=text|file] [telemetry=file.csv|file.json] [telemetryms=100] [engine=specialized|generic] [search=binary|fence|batch] [searches=5] [workload=sort|uniform|zipf|loop|scan|phased] [accesses=1000000] [writes=25] [zipf=0.99] [loop=N] [phase=100000] [phases=uniform,zipf,loop,scan] [faultio=sync|async] [iodepth=4] [disklatency=0] [check=off|on]" << endl;
+        return 1;
+    }
+    // command line arguments
+    int frameSize = stoi(argv[1]);
+    int numPhysical = stoi(argv[2]);
+    int numVirtual = stoi(argv[3]);
+    string replacement = argv[4];
+    unsigned int printInterval = stoi(argv[5]);
+    string diskFileName = argv[6];
+    bool hasThreadCount = (argc > 7 && strchr(argv[7], '=') == NULL);
+    int threadCount = hasThreadCount ? stoi(argv[7]) : 1;
+    map<string, string> options = parseOptions(argc, argv, hasThreadCount ? 8 : 7);
+    string sortMode = optionValue(options, "sort", "merge");
+    if (sortMode != "merge" && sortMode != "external" && sortMode != "parallel")
+    {
+        cout << "Error: unknown sort " << sortMode << ", use merge, external or parallel" << endl;
+        return 1;
+    }
+    externalSort = (sortMode == "external");
+    // the threads of the parallel sort are workers of one process
+    sharedAddressSpace = (sortMode == "parallel");
+    string writeback = optionValue(options, "writeback", "sync");
+    if (writeback != "sync" && writeback != "background")
+    {
+        cout << "Error: unknown writeback " << writeback << ", use sync or background" << endl;
+        return 1;
+    }
+    backgroundWriteback = (writeback == "background");
+    string readahead = optionValue(options, "readahead", "off");
+    if (readahead != "off" && readahead != "on")
+    {
+        cout << "Error: unknown readahead " << readahead << ", use off or on" << endl;
+        return 1;
+    }
+    readaheadEnabled = (readahead == "on");
+    pageoutClusterPages = stoi(optionValue(options, "cluster", "1"));
+    if (pageoutClusterPages < 1 || pageoutClusterPages > PAGEOUT_CLUSTER_MAX)
+    {
+        cout << "Error: cluster must be between 1 and " << PAGEOUT_CLUSTER_MAX << endl;
+        return 1;
+    }
+    zswapPoolPages = stoi(optionValue(options, "zswap", "0"));
+    if (zswapPoolPages < 0)
+    {
+        cout << "Error: zswap must be 0 or more pages" << endl;
+        return 1;
+    }
+    string check = optionValue(options, "check", "off");
+    if (check != "off" && check != "on")
+    {
+        cout << "Error: unknown check " << check << ", use off or on" << endl;
+        return 1;
+    }
+    string dump = optionValue(options, "dump", "");
+    pageTableDump = dump.empty() ? DUMP_OFF : (dump == "text") ? DUMP_TEXT : DUMP_BINARY;
+    if (pageTableDump == DUMP_BINARY)
+    {
+        dumpFd = open(dump.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+        if (dumpFd == -1)
+        {
+            cout << "Error: Cannot open " << dump << endl;
+            return 1;
+        }
+    }
+    telemetryFileName = optionValue(options, "telemetry", "");
+    telemetryIntervalMs = stoi(optionValue(options, "telemetryms", "100"));
+    if (telemetryIntervalMs < 1)
+    {
+        cout << "Error: telemetryms must be positive" << endl;
+        return 1;
+    }
+    string engine = optionValue(options, "engine", "specialized");
+    if (engine != "specialized" && engine != "generic")
+    {
+        cout << "Error: unknown engine " << engine << ", use specialized or generic" << endl;
+        return 1;
+    }
+    genericEngine = (engine == "generic");
+    string search = optionValue(options, "search", "binary");
+    if (search != "binary" && search != "fence" && search != "batch")
+    {
+        cout << "Error: unknown search " << search << ", use binary, fence or batch" << endl;
+        return 1;
+    }
+    searchMode = (search == "binary") ? SEARCH_BINARY : (search == "fence") ? SEARCH_FENCE : SEARCH_BATCH;
+    int searches = stoi(optionValue(options, "searches", to_string(SEARCH_COUNT)));
+    if (searches < 1)
+    {
+        cout << "Error: searches must be positive" << endl;
+        return 1;
+    }
+    // the first keys are searchNumbers, the others random keys of which about one in ten is not in the arrays
+    searchKeys.assign(searchNumbers, searchNumbers + min(searches, SEARCH_COUNT));
+    unsigned int keySeed = 312;
+    while ((int)searchKeys.size() < searches)
+    {
+        searchKeys.push_back(rand_r(&keySeed) % 1100);
+    }
+    if (!applyDiskOptions(options) || !applyPageTableOption(options) || !applyAllocationOption(options) ||
+        !applyWorkloadOptions(options) || !applyFaultIOOptions(options))
+        return 1;
+    if (sharedAddressSpace && frameAllocation != ALLOCATION_GLOBAL)
+    {
+        cout << "Error: the workers of sort=parallel share their pages, use allocation=global" << endl;
+        return 1;
+    }
+    if (workload.kind != WORKLOAD_SORT && (sharedAddressSpace || externalSort))
+    {
+        cout << "Error: sort=" << sortMode << " only applies to workload=sort" << endl;
+        return 1;
+    }
+
+    // check  max and argumants
+
+    // the external sort ping-pongs its runs between the array and as many scratch pages
+    initializeSimulation(frameSize, numPhysical, numVirtual, replacement, printInterval, diskFileName, threadCount, externalSort ? (int)pow(2, numVirtual) : 0);
+    if (backgroundWriteback)
+        startFlusher();
+    if (asyncFaultIO)
+        startFaultIO();
+    string traceFileName = optionValue(options, "trace", "");
+    if (!traceFileName.empty())
+        openTrace(traceFileName);
+    if (!telemetryFileName.empty() && !startTelemetry())
+        return 1;
+
+    // every simulated process runs on its own thread. a single process runs on the main thread
+    vector<vector<int>> searchResults;
+    if (workload.kind == WORKLOAD_SORT)
+        runSortArrays(searchResults);
+    else
+        runWorkloads();
+
+    printf("-----------------------------------------\n");
+    if (workload.kind != WORKLOAD_SORT)
+        printf("After %s workload\n", workloadNames[workload.kind]);
+    else
+        printf(externalSort ? "After external merge sort\n" : sharedAddressSpace ? "After parallel merge sort\n" : "After merge sort\n");
+    // print: --------------------\n
+    printf("-----------------------------------------\n");
+    // print physical memory
+    // printPhysicalMemory();
+
+    // print disk
+    // printDisk();
+
+    // final flush of the dirty pages
+    if (backgroundWriteback)
+        stopFlusher();
+    if (asyncFaultIO)
+        stopFaultIO();
+    if (check == "on" && !checkFrameTable())
+        return 1;
+    if (telemetryEnabled)
+        stopTelemetry();
+    closeDisk();
+    if (traceFd != -1)
+        closeTrace();
+    if (dumpFd != -1)
+    {
+        close(dumpFd);
+        dumpFd = -1;
+    }
+
+    mergeStatistics();
+    // the workers of the parallel sort searched one array
+    int processes = sharedAddressSpace ? 1 : numThreads;
+    for (int t = 1; t <= processes; t++)
+    {
+        if (workload.kind != WORKLOAD_SORT)
+        {
+            if (processes > 1)
+            {
+                cout << "Statistics of Thread " << t << ":" << endl;
+                printStatistics(threadStats[t].stats);
+            }
+            continue;
+        }
+
+        // print the found and not found numbers
+        if (processes == 1)
+            cout << "Search Results:" << endl;
+        else
+            cout << "Search Results of Thread " << t << ":" << endl;
+
+        printf("┌───────────────┬───────────────┐\n");
+        printf("│ Search Number │    Status     │\n");
+        printf("├───────────────┼───────────────┤\n");
+
+        for (int i = 0; i < min(SEARCH_COUNT, (int)searchKeys.size()); i++)
+        {
+            if (searchResults[t][i] == -1)
+            {
+                printf("│ %13d │ %-13s │\n", searchNumbers[i], "not found");
+            }
+            else
+            {
+                printf("│ %13d │ %-13s │\n", searchNumbers[i], "found");
+            }
+        }
+
+        printf("└───────────────┴───────────────┘\n");
+
+        if (processes > 1)
+        {
+            cout << "Statistics of Thread " << t << ":" << endl;
+            printStatistics(threadStats[t].stats);
+        }
+    }
+    if (sharedAddressSpace && numThreads > 1)
+    {
+        for (int t = 1; t <= numThreads; t++)
+        {
+            cout << "Statistics of Worker " << t << ":" << endl;
+            printStatistics(threadStats[t].stats);
+        }
+        printWorkerTable();
+    }
+
+    // print the statistics
+    if (numThreads > 1)
+        cout << (sharedAddressSpace ? "Statistics of All Workers:" : "Statistics of All Threads:") << endl;
+    printStatistics(statsOfProgram);
+    if (pageTable.mode != PAGE_TABLE_FLAT)
+        printf("Page table: %s, %zu KB\n", pageTable.mode == PAGE_TABLE_RADIX ? "radix" : "inverted", pageTable.bytes() / 1024);
+    if (!telemetryFileName.empty())
+        printFaultLatency();
+    if (workload.kind == WORKLOAD_SORT && (int)searchKeys.size() > SEARCH_COUNT)
+        printSearchStatistics(searchResults, processes);
+    if (workload.kind != WORKLOAD_SORT)
+        printWorkloadStatistics();
+
+    return 0;
+}
+
+// faultBench: measures the cost of one page fault while the number of physical frames grows.
+// the first pass over the pages faults into free frames, the next passes fault on a loop that is
+// four times larger than the physical memory, so every access evicts a page.
+int fault_bench_program(int argc, char *argv[])
+{
+    if (argc < 6)
+    {
+        cout << "Usage: faultBench frameSize minPhysical maxPhysical pageReplacement diskFileName.dat [disk=file|mmap] [pagetable=flat|radix|inverted]" << endl;
+        return 1;
+    }
+    map<string, string> options = parseOptions(argc, argv, 6);
+    if (!applyDiskOptions(options) || !applyPageTableOption(options))
+        return 1;
+    int frameSize = stoi(argv[1]);
+    int minPhysical = stoi(argv[2]);
+    int maxPhysical = stoi(argv[3]);
+    string replacement = argv[4];
+    string diskFileName = argv[5];
+    const int rounds = 3; // replacement passes over the virtual pages
+
+    printf("┌──────────────┬──────────────┬────────────────────┬────────────────────┐\n");
+    printf("│ Phys. Frames │ Virt. Pages  │ Free Frame ns/flt  │ Replacement ns/flt │\n");
+    printf("├──────────────┼──────────────┼────────────────────┼────────────────────┤\n");
+
+    for (int numPhysical = minPhysical; numPhysical <= maxPhysical; numPhysical++)
+    {
+        int numVirtual = numPhysical + 2;
+        initializeSimulation(frameSize, numPhysical, numVirtual, replacement, UINT_MAX, diskFileName, 1);
+
+        // first touch of every page. the first physical_frame_number faults take a free frame
+        auto start = chrono::steady_clock::now();
+        for (int i = 0; i < physical_frame_number; i++)
+        {
+            get(1, i * globalFrameSize);
+        }
+        auto end = chrono::steady_clock::now();
+        double freeFrameNs = chrono::duration<double, nano>(end - start).count() / physical_frame_number;
+
+        for (int i = physical_frame_number; i < virtual_page_number; i++)
+        {
+            get(1, i * globalFrameSize);
+        }
+
+        // every access of the loop misses and replaces a page
+        unsigned int missesBefore = threadStats[1].stats.pageMisses;
+        start = chrono::steady_clock::now();
+        for (int r = 0; r < rounds; r++)
+        {
+            for (int i = 0; i < virtual_page_number; i++)
+            {
+                get(1, i * globalFrameSize);
+            }
+        }
+        end = chrono::steady_clock::now();
+        unsigned int misses = threadStats[1].stats.pageMisses - missesBefore;
+        double replacementNs = chrono::duration<double, nano>(end - start).count() / (misses ? misses : 1);
+
+        printf("│ %12d │ %12d │ %18.1f │ %18.1f │\n", physical_frame_number, virtual_page_number, freeFrameNs, replacementNs);
+
+        closeDisk();
+        unlink(diskFileName.c_str());
+    }
+
+    printf("└──────────────┴──────────────┴────────────────────┴────────────────────┘\n");
+    return 0;
+}
+
+// hitBench: cost of one access that hits in the physical memory, with and without the TLB. all pages fit in
+// the physical memory. the sequential pattern walks every page, the hot pattern jumps between the pages of a
+// hot set that fits in the TLB but is spread over the page table.
+int hit_bench_program(int argc, char *argv[])
+{
+    if (argc != 6)
+    {
+        cout << "Usage: hitBench frameSize numPhysical pageReplacement diskFileName.dat rounds" << endl;
+        return 1;
+    }
+    int frameSize = stoi(argv[1]);
+    int numPhysical = stoi(argv[2]);
+    string replacement = argv[3];
+    string diskFileName = argv[4];
+    int rounds = stoi(argv[5]);
+
+    printf("┌──────────────┬──────────┬──────────────┬──────────────┐\n");
+    printf("│ Pattern      │ TLB      │ ns/access    │ TLB Hit Rate │\n");
+    printf("├──────────────┼──────────┼──────────────┼──────────────┤\n");
+
+    const char *patterns[] = {"sequential", "hot set"};
+    for (int pattern = 0; pattern < 2; pattern++)
+    {
+        for (int useTLB = 0; useTLB <= 1; useTLB++)
+        {
+            initializeSimulation(frameSize, numPhysical, numPhysical, replacement, UINT_MAX, diskFileName, 1);
+            tlbEnabled = useTLB;
+
+            // bring every page into the physical memory
+            unsigned int size = virtual_page_number * globalFrameSize;
+            for (unsigned int i = 0; i < size; i += globalFrameSize)
+            {
+                set(1, i, i);
+            }
+
+            // the hot set has three quarters as many pages as the TLB has entries
+            unsigned int hotPages = min(virtual_page_number, TLB_SETS * TLB_WAYS * 3 / 4);
+            unsigned int position = 12345;
+            unsigned long long accesses = 0;
+            long long sum = 0;
+            Statistics before = threadStats[1].stats;
+            auto start = chrono::steady_clock::now();
+            for (int r = 0; r < rounds; r++)
+            {
+                for (unsigned int i = 0; i < size; i++)
+                {
+                    if (pattern == 0)
+                    {
+                        sum += get(1, i);
+                    }
+                    else
+                    {
+                        // the hot pages are spread over the whole page table
+                        position = position * 1103515245 + 12345;
+                        unsigned int page = ((position >> 8) % hotPages) * (virtual_page_number / hotPages);
+                        sum += get(1, page * globalFrameSize + (position >> 20) % globalFrameSize);
+                    }
+                }
+                accesses += size;
+            }
+            auto end = chrono::steady_clock::now();
+            const Statistics &after = threadStats[1].stats;
+            unsigned int hits = after.tlbHits - before.tlbHits;
+            unsigned int lookups = hits + after.tlbMisses - before.tlbMisses;
+
+            double ns = chrono::duration<double, nano>(end - start).count() / accesses;
+            printf("│ %-12s │ %-8s │ %12.2f │ %11.2f%% │\n", patterns[pattern], useTLB ? "on" : "off", ns, lookups ? 100.0 * hits / lookups : 0.0);
+            if (sum == 42) // keep the loads alive
+                printf(" ");
+
+            closeDisk();
+            unlink(diskFileName.c_str());
+        }
     }
+    tlbEnabled = true;
 
-    return -1;
+    printf("└──────────────┴──────────┴──────────────┴──────────────┘\n");
+    return 0;
 }
-// physical memory.  threads share the same physical memory.
 
-int main(int argc, char *argv[])
+// one simulated process of scaleBench: passes over its own pages, every access touches a new page
+void scaleBenchProcess(unsigned int threadNum, int rounds)
 {
+    for (int r = 0; r < rounds; r++)
+    {
+        for (int i = 0; i < virtual_page_number; i++)
+        {
+            get(threadNum, i * globalFrameSize);
+        }
+    }
+}
 
+// scaleBench: fault throughput of 1, 2, 4, ... maxThreads processes that share the physical memory.
+// every process has numVirtual pages of its own, so the processes fault on different pages.
+int scale_bench_program(int argc, char *argv[])
+{
     if (argc != 7)
     {
-        cout << "Usage: sortArrays frameSize numPhysical numVirtual pageReplacement pageTablePrintInt diskFileName.dat" << endl;
+        cout << "Usage: scaleBench frameSize numPhysical numVirtual pageReplacement diskFileName.dat maxThreads" << endl;
         return 1;
     }
-    // command line arguments
     int frameSize = stoi(argv[1]);
     int numPhysical = stoi(argv[2]);
     int numVirtual = stoi(argv[3]);
-    pageReplacement = argv[4];
-    pageTablePrintInt = stoi(argv[5]);
+    string replacement = argv[4];
+    string diskFileName = argv[5];
+    int maxThreads = stoi(argv[6]);
+    const int rounds = 4; // passes of every process over its pages
+
+    printf("┌──────────┬──────────────┬──────────────┬──────────────┬──────────┐\n");
+    printf("│ Threads  │ Page Faults  │ Seconds      │ Faults/sec   │ Speedup  │\n");
+    printf("├──────────┼──────────────┼──────────────┼──────────────┼──────────┤\n");
+
+    double baseThroughput = 0;
+    for (int threadCount = 1; threadCount <= maxThreads; threadCount *= 2)
+    {
+        initializeSimulation(frameSize, numPhysical, numVirtual, replacement, UINT_MAX, diskFileName, threadCount);
+
+        auto start = chrono::steady_clock::now();
+        vector<thread> processes;
+        for (int t = 1; t <= threadCount; t++)
+        {
+            processes.push_back(thread(scaleBenchProcess, t, rounds));
+        }
+        for (size_t t = 0; t < processes.size(); t++)
+        {
+            processes[t].join();
+        }
+        auto end = chrono::steady_clock::now();
+
+        // every fault of a get reads the page from the disk, or fills it if it was never written
+        mergeStatistics();
+        unsigned int faults = statsOfProgram.diskPageReads + statsOfProgram.firstTouchPages;
+        double seconds = chrono::duration<double>(end - start).count();
+        double throughput = faults / seconds;
+        if (threadCount == 1)
+            baseThroughput = throughput;
+
+        printf("│ %8d │ %12u │ %12.4f │ %12.0f │ %8.2f │\n", threadCount, faults, seconds, throughput, throughput / baseThroughput);
+
+        closeDisk();
+        unlink(diskFileName.c_str());
+    }
+
+    printf("└──────────┴──────────────┴──────────────┴──────────────┴──────────┘\n");
+    return 0;
+}
+
+// parallelSortBench: time of the merge sort of one array on one thread and on workers threads that share its
+// pages, from 2^minPhysical to 2^maxPhysical physical frames. only the sort is timed and counted, the array is
+// filled before. when the frames hold the array the workers scale with the cores, when they fault the pager
+// lock and the disk serialize them
+int parallel_sort_bench_program(int argc, char *argv[])
+{
+    if (argc != 8)
+    {
+        cout << "Usage: parallelSortBench frameSize minPhysical maxPhysical numVirtual pageReplacement diskFileName.dat workers" << endl;
+        return 1;
+    }
+    int frameSize = stoi(argv[1]);
+    int minPhysical = stoi(argv[2]);
+    int maxPhysical = stoi(argv[3]);
+    int numVirtual = stoi(argv[4]);
+    string replacement = argv[5];
     string diskFileName = argv[6];
+    int workers = stoi(argv[7]);
+    if (workers < 1 || workers > MAX_THREADS)
+    {
+        cout << "Error: workers must be between 1 and " << MAX_THREADS << endl;
+        return 1;
+    }
 
-    // check  max and argumants
+    printf("┌──────────┬──────────────┬──────────────┬──────────┬──────────────┬──────────────┬──────────┐\n");
+    printf("│ Frames   │ Sequential s │ Parallel s   │ Speedup  │ Seq Misses   │ Par Misses   │ Steals   │\n");
+    printf("├──────────┼──────────────┼──────────────┼──────────┼──────────────┼──────────────┼──────────┤\n");
 
-    // numVirtual = (2^numVirtual)
-    numVirtual = pow(2, numVirtual);
-    frameSize = pow(2, frameSize);
-    numPhysical = pow(2, numPhysical);
+    for (int numPhysical = minPhysical; numPhysical <= maxPhysical; numPhysical++)
+    {
+        double seconds[2];
+        unsigned int misses[2];
+        unsigned int steals = 0;
+        for (int parallel = 0; parallel < 2; parallel++)
+        {
+            sharedAddressSpace = (parallel == 1);
+            initializeSimulation(frameSize, numPhysical, numVirtual, replacement, UINT_MAX, diskFileName, parallel ? workers : 1);
+            fillVirtualMemory(1);
+            mergeStatistics();
+            unsigned int fillMisses = statsOfProgram.pageMisses;
 
-    // physical_memory_size = (2^frameSize)* (2^numPhysical)
-    physical_memory_size = frameSize * numPhysical;
-    // print physical memory size
-    virtual_page_number = numVirtual;
-    disk_size = numVirtual * frameSize * 2;
-    disk_file_name = diskFileName;
-    globalFrameSize = frameSize;
-    statsOfProgram.physicalFramesInMemory = numPhysical;
+            auto start = chrono::steady_clock::now();
+            if (parallel)
+                parallelMergeSort();
+            else
+                mergeSort(1, 0, virtual_page_number * globalFrameSize - 1);
+            auto end = chrono::steady_clock::now();
 
-    // init page table
-    initializePageTable();
-    // init physical memory
-    initializePhysicalMemory();
+            mergeStatistics();
+            seconds[parallel] = chrono::duration<double>(end - start).count();
+            misses[parallel] = statsOfProgram.pageMisses - fillMisses;
+            closeDisk();
+            unlink(diskFileName.c_str());
+        }
+        for (int t = 1; t <= workers; t++)
+        {
+            steals += workerDeques[t].steals;
+        }
 
-    // print physical memory
-    // printPhysicalMemory();
+        printf("│ %8d │ %12.4f │ %12.4f │ %8.2f │ %12u │ %12u │ %8u │\n", physical_frame_number, seconds[0], seconds[1],
+               seconds[0] / seconds[1], misses[0], misses[1], steals);
+    }
 
-    // init disk
-    initializeDisk();
+    printf("└──────────┴──────────────┴──────────────┴──────────┴──────────────┴──────────────┴──────────┘\n");
+    sharedAddressSpace = false;
+    return 0;
+}
 
-    fillVirtualMemory(1);
+// ioDepthBench: disk reads per second of threads processes that run a workload on more pages than the frames,
+// every disk read takes latencyUs microseconds. the first row makes the faults wait for their reads, one read
+// of every process is outstanding. the others start the page-ins of the next 1, 2, 4, ... maxDepth accesses of
+// every process with as many I/O threads (faultio=async), the speedup is against the first row. the fill has no
+// disk reads, the pages are on the disk after it
+int io_depth_bench_program(int argc, char *argv[])
+{
+    if (argc < 9)
+    {
+        cout << "Usage: ioDepthBench frameSize numPhysical numVirtual pageReplacement diskFileName.dat threads maxDepth latencyUs [workload=uniform] [accesses=2000] [writes=25]" << endl;
+        return 1;
+    }
+    int frameSize = stoi(argv[1]);
+    int numPhysical = stoi(argv[2]);
+    int numVirtual = stoi(argv[3]);
+    string replacement = argv[4];
+    string diskFileName = argv[5];
+    int threadCount = stoi(argv[6]);
+    int maxDepth = stoi(argv[7]);
+    int latencyUs = stoi(argv[8]);
+    map<string, string> options = parseOptions(argc, argv, 9);
+    if (options.find("workload") == options.end())
+        options["workload"] = "uniform";
+    if (options.find("accesses") == options.end())
+        options["accesses"] = "2000";
+    if (!applyWorkloadOptions(options))
+        return 1;
+    if (workload.kind == WORKLOAD_SORT || threadCount < 1 || threadCount > MAX_THREADS || maxDepth < 1 || maxDepth > MAX_THREADS || latencyUs < 0)
+    {
+        cout << "Error: use a workload other than sort, threads and maxDepth between 1 and " << MAX_THREADS << " and latencyUs >= 0" << endl;
+        return 1;
+    }
 
-    // print physical memory
-    // printPhysicalMemory();
+    printf("┌──────────┬──────────┬──────────────┬──────────────┬──────────────┬──────────┐\n");
+    printf("│ Fault IO │ IO Depth │ Disk Reads   │ Seconds      │ Reads/sec    │ Speedup  │\n");
+    printf("├──────────┼──────────┼──────────────┼──────────────┼──────────────┼──────────┤\n");
 
-    // print disk
-    // printDisk();
+    // depth 0 is the synchronous read of the faults
+    double baseThroughput = 0;
+    for (int depth = 0; depth <= maxDepth; depth = max(1, depth * 2))
+    {
+        asyncFaultIO = (depth > 0);
+        ioDepth = max(1, depth);
+        diskReadLatencyUs = latencyUs;
+        initializeSimulation(frameSize, numPhysical, numVirtual, replacement, UINT_MAX, diskFileName, threadCount);
+        if (asyncFaultIO)
+            startFaultIO();
 
-    // merge sort
-    mergeSort(1, 0, (virtual_page_number * globalFrameSize) - 1);
+        // the reads that were started ahead and not waited for are done when the I/O threads stop
+        auto start = chrono::steady_clock::now();
+        runWorkloads();
+        if (asyncFaultIO)
+            stopFaultIO();
+        auto end = chrono::steady_clock::now();
+        unsigned int reads = 0;
+        for (int t = 1; t <= threadCount; t++)
+        {
+            reads += workloadStats[t].diskPageReads;
+        }
+        double seconds = chrono::duration<double>(end - start).count();
+        double throughput = reads / seconds;
+        if (depth == 0)
+            baseThroughput = throughput;
 
-    printf("-----------------------------------------\n");
-    printf("After merge sort\n");
-    // print: --------------------\n
-    printf("-----------------------------------------\n");
-    // print physical memory
-    // printPhysicalMemory();
+        printf("│ %-8s │ %8s │ %12u │ %12.4f │ %12.0f │ %8.2f │\n", depth ? "async" : "sync", depth ? to_string(depth).c_str() : "-",
+               reads, seconds, throughput, throughput / baseThroughput);
 
-    // print disk
-    // printDisk();
+        closeDisk();
+        unlink(diskFileName.c_str());
+    }
+
+    printf("└──────────┴──────────┴──────────────┴──────────────┴──────────────┴──────────┘\n");
+    asyncFaultIO = false;
+    diskReadLatencyUs = 0;
+    return 0;
+}
+
+// localityBench: processes with very different locality share the physical memory. process t accesses random
+// integers of its hot set of physical_frame_number / 2^(processes - t) pages, a quarter of the accesses are
+// writes. the processes take turns of quantum accesses on one thread, so every frame allocation runs exactly
+// the same accesses. with long turns a global policy hands all the frames to the running process
+int locality_bench_program(int argc, char *argv[])
+{
+    if (argc < 7)
+    {
+        cout << "Usage: localityBench frameSize numPhysical pageReplacement diskFileName.dat processes accesses [quantum=10]" << endl;
+        return 1;
+    }
+    map<string, string> options = parseOptions(argc, argv, 7);
+    int frameSize = stoi(argv[1]);
+    int numPhysical = stoi(argv[2]);
+    string replacement = argv[3];
+    string diskFileName = argv[4];
+    int processes = stoi(argv[5]);
+    int accesses = stoi(argv[6]);
+    int quantum = stoi(optionValue(options, "quantum", "10"));
+    if (processes < 1 || processes > MAX_THREADS)
+    {
+        cout << "Error: processes must be between 1 and " << MAX_THREADS << endl;
+        return 1;
+    }
+    if (quantum < 1)
+    {
+        cout << "Error: quantum must be positive" << endl;
+        return 1;
+    }
+
+    printf("┌────────────┬─────────┬───────────┬────────┬────────┬──────────────┐\n");
+    printf("│ Allocation │ Process │ Hot Pages │ Frames │ Quota  │  Page Misses │\n");
+    for (int mode = ALLOCATION_GLOBAL; mode <= ALLOCATION_WS; mode++)
+    {
+        frameAllocation = (FrameAllocation)mode;
+        initializeSimulation(frameSize, numPhysical, numPhysical, replacement, UINT_MAX, diskFileName, processes);
+
+        // srand(1000 * t) for process t, the same generator as fillVirtualMemory
+        vector<vector<char>> randomStates(processes + 1, vector<char>(128));
+        vector<struct random_data> randomData(processes + 1);
+        vector<int> hotPages(processes + 1);
+        for (int t = 1; t <= processes; t++)
+        {
+            randomData[t] = {};
+            initstate_r(1000 * t, &randomStates[t][0], randomStates[t].size(), &randomData[t]);
+            hotPages[t] = max(1, physical_frame_number >> (processes - t));
+        }
+
+        for (int done = 0; done < accesses; done += quantum)
+        {
+            for (int t = 1; t <= processes; t++)
+            {
+                for (int i = done; i < min(accesses, done + quantum); i++)
+                {
+                    int32_t randomNumber;
+                    random_r(&randomData[t], &randomNumber);
+                    int page = randomNumber % hotPages[t];
+                    int index = page * globalFrameSize + (randomNumber / hotPages[t]) % globalFrameSize;
+                    if ((randomNumber >> 29) == 0)
+                        set(t, index, randomNumber);
+                    else
+                        get(t, index);
+                }
+            }
+        }
+
+        unsigned int totalMisses = 0;
+        printf("├────────────┼─────────┼───────────┼────────┼────────┼──────────────┤\n");
+        for (int t = 1; t <= processes; t++)
+        {
+            char quota[16] = "-";
+            if (frameAllocation != ALLOCATION_GLOBAL)
+                snprintf(quota, sizeof(quota), "%d", frameQuota[t]);
+            printf("│ %-10s │ %7d │ %9d │ %6d │ %6s │ %12u │\n", allocationNames[mode], t, hotPages[t], framesHeld[t], quota, threadStats[t].stats.pageMisses);
+            totalMisses += threadStats[t].stats.pageMisses;
+        }
+        printf("│ %-10s │ %7s │ %9s │ %6d │ %6s │ %12u │\n", allocationNames[mode], "all", "", physical_frame_number, "", totalMisses);
+
+        closeDisk();
+        unlink(diskFileName.c_str());
+    }
+    printf("└────────────┴─────────┴───────────┴────────┴────────┴──────────────┘\n");
+    frameAllocation = ALLOCATION_GLOBAL;
+    return 0;
+}
+
+// sweepBench: runs the sortArrays workload for every combination of frameSize, numPhysical, numVirtual and
+// policy and writes one CSV row per combination. the sizes are powers of two like on the sortArrays command
+// line. every combination runs warmup times without measuring, then repetitions times; the row has the median
+// and the minimum wall time and the statistics of the last repetition, which are the same in every repetition
+// of a single process run
+int sweep_bench_program(int argc, char *argv[])
+{
+    if (argc < 7)
+    {
+        cout << "Usage: sweepBench frameSizes numPhysicals numVirtuals policies diskFileName.dat results.csv [warmup=1] [repetitions=3] [threads=1] [sort=merge|external|parallel] [disk=file|mmap]" << endl;
+        return 1;
+    }
+    vector<int> frameSizes = parseIntList(argv[1]);
+    vector<int> physicals = parseIntList(argv[2]);
+    vector<int> virtuals = parseIntList(argv[3]);
+    vector<string> policies = parseNameList(argv[4]);
+    string diskFileName = argv[5];
+    string csvFileName = argv[6];
+    map<string, string> options = parseOptions(argc, argv, 7);
+    int warmup = stoi(optionValue(options, "warmup", "1"));
+    int repetitions = max(1, stoi(optionValue(options, "repetitions", "3")));
+    int threadCount = stoi(optionValue(options, "threads", "1"));
+    string sortMode = optionValue(options, "sort", "merge");
+    if (sortMode != "merge" && sortMode != "external" && sortMode != "parallel")
+    {
+        cout << "Error: unknown sort " << sortMode << ", use merge, external or parallel" << endl;
+        return 1;
+    }
+    if (warmup < 0)
+    {
+        cout << "Error: warmup must be 0 or more runs" << endl;
+        return 1;
+    }
+    if (threadCount < 1 || threadCount > MAX_THREADS)
+    {
+        cout << "Error: threads must be between 1 and " << MAX_THREADS << endl;
+        return 1;
+    }
+    externalSort = (sortMode == "external");
+    sharedAddressSpace = (sortMode == "parallel");
+    if (!applyDiskOptions(options))
+        return 1;
+
+    FILE *csv = fopen(csvFileName.c_str(), "w");
+    if (csv == NULL)
+    {
+        cout << "Error: Cannot open " << csvFileName << endl;
+        return 1;
+    }
+    fprintf(csv, "frameSize,numPhysical,numVirtual,policy,threads,sort,repetitions,wall_ms_median,wall_ms_min,accesses_per_sec,page_misses,page_replacements,disk_reads,disk_writes\n");
+
+    for (size_t f = 0; f < frameSizes.size(); f++)
+    {
+        for (size_t p = 0; p < physicals.size(); p++)
+        {
+            for (size_t v = 0; v < virtuals.size(); v++)
+            {
+                for (size_t r = 0; r < policies.size(); r++)
+                {
+                    int frameSize = frameSizes[f];
+                    int numPhysical = physicals[p];
+                    int numVirtual = virtuals[v];
+                    const string &replacement = policies[r];
+                    int scratchPages = externalSort ? (int)pow(2, numVirtual) : 0;
+                    if (!simulationFits((long long)pow(2, frameSize), (long long)pow(2, numVirtual) + scratchPages, sharedAddressSpace ? 1 : threadCount, (long long)pow(2, numPhysical)))
+                    {
+                        cout << "skip " << frameSize << " " << numPhysical << " " << numVirtual << " " << replacement << ": too many pages" << endl;
+                        continue;
+                    }
+
+                    vector<double> wallMs;
+                    for (int run = 0; run < warmup + repetitions; run++)
+                    {
+                        initializeSimulation(frameSize, numPhysical, numVirtual, replacement, UINT_MAX, diskFileName, threadCount, scratchPages);
+                        vector<vector<int>> searchResults;
+                        auto start = chrono::steady_clock::now();
+                        runSortArrays(searchResults);
+                        auto end = chrono::steady_clock::now();
+                        closeDisk();
+                        if (run >= warmup)
+                            wallMs.push_back(chrono::duration<double, milli>(end - start).count());
+                    }
+                    unlink(diskFileName.c_str());
+
+                    mergeStatistics();
+                    sort(wallMs.begin(), wallMs.end());
+                    double median = wallMs[wallMs.size() / 2];
+                    double accesses = (double)statsOfProgram.reads + statsOfProgram.writes;
+                    fprintf(csv, "%d,%d,%d,%s,%d,%s,%d,%.3f,%.3f,%.0f,%u,%u,%u,%u\n", frameSize, numPhysical, numVirtual,
+                            replacement.c_str(), threadCount, sortMode.c_str(), repetitions, median, wallMs[0],
+                            accesses / (median / 1000), statsOfProgram.pageMisses, statsOfProgram.pageReplacements,
+                            statsOfProgram.diskPageReads, statsOfProgram.diskPageWrites);
+                    fflush(csv);
+                    printf("%d %d %d %-5s %10.3f ms %12u misses\n", frameSize, numPhysical, numVirtual, replacement.c_str(), median, statsOfProgram.pageMisses);
+                }
+            }
+        }
+    }
+
+    fclose(csv);
+    return 0;
+}
+
+// engineBench: accesses per second of the generic engine and of the engine of the page size and the policy, for
+// every policy. resident: gets that walk a virtual memory as large as the physical memory, every page is resident.
+// faulting: random gets and sets, a quarter of them writes, over twice as many pages as frames
+int engine_bench_program(int argc, char *argv[])
+{
+    if (argc != 6)
+    {
+        cout << "Usage: engineBench frameSize numPhysical policies diskFileName.dat rounds" << endl;
+        return 1;
+    }
+    int frameSize = stoi(argv[1]);
+    int numPhysical = stoi(argv[2]);
+    vector<string> policies = parseNameList(argv[3]);
+    string diskFileName = argv[4];
+    int rounds = stoi(argv[5]);
 
-    // search 5 numbers (2 of them not in the array)
-    int searchNumbers[] = {994, 966, 899, 110, 290}; // 110 ve 290 diskte kesin yok
-    int searchResults[5];
+    printf("┌──────────┬──────────────┬──────────────┬──────────────┬──────────┐\n");
+    printf("│ Policy   │ Pattern      │ Generic M/s  │ Engine M/s   │ Speedup  │\n");
+    printf("├──────────┼──────────────┼──────────────┼──────────────┼──────────┤\n");
 
-    for (int i = 0; i < 5; i++)
+    const char *patterns[] = {"resident", "faulting"};
+    for (size_t r = 0; r < policies.size(); r++)
     {
-        searchResults[i] = binarySearch(1, 0, virtual_page_number * globalFrameSize - 1, searchNumbers[i]);
+        for (int pattern = 0; pattern < 2; pattern++)
+        {
+            double perSecond[2];
+            for (int generic = 1; generic >= 0; generic--)
+            {
+                genericEngine = generic;
+                initializeSimulation(frameSize, numPhysical, numPhysical + pattern, policies[r], UINT_MAX, diskFileName, 1);
+                unsigned int size = virtual_page_number * globalFrameSize;
+                for (unsigned int i = 0; i < size; i += globalFrameSize)
+                {
+                    set(1, i, i);
+                }
+
+                unsigned int position = 12345;
+                unsigned long long accesses = 0;
+                long long sum = 0;
+                auto start = chrono::steady_clock::now();
+                for (int round = 0; round < rounds; round++)
+                {
+                    for (unsigned int i = 0; i < size; i++)
+                    {
+                        if (pattern == 0)
+                        {
+                            sum += get(1, i);
+                            continue;
+                        }
+                        position = position * 1103515245 + 12345;
+                        unsigned int index = (position >> 4) % size;
+                        if ((position >> 28) < 4)
+                            set(1, index, i);
+                        else
+                            sum += get(1, index);
+                    }
+                    accesses += size;
+                }
+                auto end = chrono::steady_clock::now();
+                perSecond[generic] = accesses / chrono::duration<double, micro>(end - start).count();
+                if (sum == 42) // keep the loads alive
+                    printf(" ");
+
+                closeDisk();
+                unlink(diskFileName.c_str());
+            }
+            printf("│ %-8s │ %-12s │ %12.2f │ %12.2f │ %8.2f │\n", policies[r].c_str(), patterns[pattern], perSecond[1], perSecond[0], perSecond[0] / perSecond[1]);
+        }
     }
+    genericEngine = false;
+
+    printf("└──────────┴──────────────┴──────────────┴──────────────┴──────────┘\n");
+    return 0;
+}
 
-    // print the found and not found numbers
-    cout << "Search Results:" << endl;
+// replay of a trace through a replacement policy. only the page table, the frame table and the policy are
+// simulated: no data is copied, the disk is not used and no lock is taken. every fault counts as a miss and
+// the evictions of modified pages are the disk writes the run would need.
+struct ReplayResult
+{
+    unsigned long long misses;
+    unsigned long long dirtyEvictions;
+    double seconds;
+};
+
+// page of a trace record in the page table of the replay
+inline int tracePage(const TraceRecord &record, const TraceHeader &header)
+{
+    return ((record.info >> 25) - 1) * header.pagesPerProcess + record.index / header.frameSize;
+}
 
-    printf("┌───────────────┬───────────────┐\n");
-    printf("│ Search Number │    Status     │\n");
-    printf("├───────────────┼───────────────┤\n");
+ReplayResult replayPolicy(const vector<TraceRecord> &records, const TraceHeader &header, const string &replacement)
+{
+    initializePageTable();
+    initializePhysicalMemory();
+    initializeTLBs();
+    initializeReadahead();
+    accessTick = 0;
+    delete policy;
+    policy = createPolicy(replacement);
 
-    for (int i = 0; i < 5; i++)
+    ReplayResult result = {0, 0, 0};
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < records.size(); i++)
     {
-        if (searchResults[i] == -1)
+        int page = tracePage(records[i], header);
+        unsigned long long accessTime = ++accessTick;
+        PageTableEntry &entry = pageTable.create(page);
+        if (entry.valid())
         {
-            printf("│ %13d │ %-13s │\n", searchNumbers[i], "not found");
+            if (policy->tracksHits)
+                policy->onHit(page);
         }
         else
         {
-            printf("│ %13d │ %-13s │\n", searchNumbers[i], "found");
+            result.misses++;
+            policy->onMiss(page);
+            int frameNumber = allocateFrame();
+            if (frameNumber == -1)
+            {
+                bool modified;
+                frameNumber = evictPage(policy->selectVictim(), modified);
+                result.dirtyEvictions += modified;
+            }
+            frameTable[frameNumber].pageIndex = page;
+            entry.setFrameNumber(frameNumber);
+            entry.setValid(1);
+            entry.setModified(0);
+            entry.setInTransit(0);
+            policy->onInsert(page);
         }
+        entry.setReferenced(1);
+        entry.setLastAccessTime(accessTime);
+        if (records[i].info & (1u << 24))
+            entry.setModified(1);
     }
+    result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return result;
+}
 
-    printf("└───────────────┴───────────────┘\n");
+// Belady's optimal policy: the victim is the resident page whose next access is the furthest in the future.
+// the next access of every record is found with one backward pass, the resident pages are kept in a max heap
+// of (next access, page) whose stale entries are skipped
+ReplayResult replayOptimal(const vector<TraceRecord> &records, const TraceHeader &header)
+{
+    size_t count = records.size();
+    size_t never = count; // next access of a page that is not accessed again
+    vector<size_t> nextAccess(count);
+    vector<size_t> nextOfPage(page_table_size, never);
+    for (size_t i = count; i-- > 0;)
+    {
+        int page = tracePage(records[i], header);
+        nextAccess[i] = nextOfPage[page];
+        nextOfPage[page] = i;
+    }
 
-    // print the statistics
-    printStatistics();
+    ReplayResult result = {0, 0, 0};
+    auto start = chrono::steady_clock::now();
+    vector<size_t> residentNext(page_table_size, 0); // next access of every resident page
+    vector<char> resident(page_table_size, 0);
+    vector<char> modified(page_table_size, 0);
+    priority_queue<pair<size_t, int>> furthest;
+    int residentCount = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        int page = tracePage(records[i], header);
+        if (!resident[page])
+        {
+            result.misses++;
+            if (residentCount == physical_frame_number)
+            {
+                // drop the entries that are not the current next access of a resident page
+                while (!resident[furthest.top().second] || residentNext[furthest.top().second] != furthest.top().first)
+                    furthest.pop();
+                int victim = furthest.top().second;
+                furthest.pop();
+                resident[victim] = 0;
+                result.dirtyEvictions += modified[victim];
+                residentCount--;
+            }
+            resident[page] = 1;
+            modified[page] = 0;
+            residentCount++;
+        }
+        if (records[i].info & (1u << 24))
+            modified[page] = 1;
+        residentNext[page] = nextAccess[i];
+        furthest.push(make_pair(nextAccess[i], page));
+    }
+    result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+// replayTrace: push a trace recorded with sortArrays trace=file through replacement policies. numPhysical is a
+// power of two like on the sortArrays command line, policies is a comma separated list, OPT is Belady's policy
+int replay_trace_program(int argc, char *argv[])
+{
+    if (argc != 4)
+    {
+        cout << "Usage: replayTrace traceFile numPhysical LRU,CL,WSCL,LFU,AGING,2Q,ARC,OPT" << endl;
+        return 1;
+    }
+    string traceFileName = argv[1];
+    int numPhysical = stoi(argv[2]);
+    string policies = argv[3];
+
+    // read the whole trace
+    int traceFile = open(traceFileName.c_str(), O_RDONLY);
+    TraceHeader header;
+    if (traceFile == -1 || read(traceFile, &header, sizeof(header)) != sizeof(header) || header.magic != TRACE_MAGIC)
+    {
+        cout << "Error: " << traceFileName << " is not a trace file" << endl;
+        return 1;
+    }
+    off_t bytes = lseek(traceFile, 0, SEEK_END) - (off_t)sizeof(header);
+    vector<TraceRecord> records(bytes / sizeof(TraceRecord));
+    if (!records.empty())
+        pread(traceFile, &records[0], records.size() * sizeof(TraceRecord), sizeof(header));
+    close(traceFile);
+
+    // the page table and the frames of the replay
+    if (header.pagesPerProcess < 1 || header.threads < 1 || !simulationFits(1, header.pagesPerProcess, header.threads, (long long)pow(2, numPhysical)))
+    {
+        cout << "Error: the trace has more pages than the page table" << endl;
+        return 1;
+    }
+    globalFrameSize = header.frameSize;
+    numThreads = header.threads;
+    process_page_number = header.pagesPerProcess;
+    virtual_page_number = header.pagesPerProcess;
+    page_table_size = process_page_number * numThreads;
+    physical_frame_number = pow(2, numPhysical);
+    physical_memory_size = 0; // no data is copied
+    concurrentMode = false;
+    backgroundWriteback = false;
+
+    printf("%zu accesses of %d processes, %d pages, %d frames\n", records.size(), numThreads, page_table_size, physical_frame_number);
+    printf("┌──────────┬──────────────┬───────────┬─────────────────┬──────────────┐\n");
+    printf("│ Policy   │       Misses │ Miss Rate │ Dirty Evictions │ M accesses/s │\n");
+    printf("├──────────┼──────────────┼───────────┼─────────────────┼──────────────┤\n");
+
+    size_t begin = 0;
+    while (begin <= policies.size())
+    {
+        size_t end = policies.find(',', begin);
+        if (end == string::npos)
+            end = policies.size();
+        string name = policies.substr(begin, end - begin);
+        begin = end + 1;
+
+        ReplayResult result;
+        if (name == "OPT")
+        {
+            result = replayOptimal(records, header);
+        }
+        else
+        {
+            ReplacementPolicy *known = createPolicy(name);
+            if (known == NULL)
+            {
+                printf("│ %-8s │ %-57s │\n", name.c_str(), "unknown policy");
+                continue;
+            }
+            delete known;
+            result = replayPolicy(records, header, name);
+        }
+        printf("│ %-8s │ %12llu │ %8.2f%% │ %15llu │ %12.1f │\n", name.c_str(), result.misses,
+               records.empty() ? 0.0 : 100.0 * result.misses / records.size(), result.dirtyEvictions,
+               records.size() / result.seconds / 1e6);
+    }
 
+    printf("└──────────┴──────────────┴───────────┴─────────────────┴──────────────┘\n");
     return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    // the same source builds every program. pick the program from the executable name
+    string program = argv[0];
+    program = program.substr(program.find_last_of('/') + 1);
+
+    if (program == "faultBench")
+    {
+        return fault_bench_program(argc, argv);
+    }
+    if (program == "hitBench")
+    {
+        return hit_bench_program(argc, argv);
+    }
+    if (program == "scaleBench")
+    {
+        return scale_bench_program(argc, argv);
+    }
+    if (program == "replayTrace")
+    {
+        return replay_trace_program(argc, argv);
+    }
+    if (program == "sweepBench")
+    {
+        return sweep_bench_program(argc, argv);
+    }
+    if (program == "localityBench")
+    {
+        return locality_bench_program(argc, argv);
+    }
+    if (program == "parallelSortBench")
+    {
+        return parallel_sort_bench_program(argc, argv);
+    }
+    if (program == "engineBench")
+    {
+        return engine_bench_program(argc, argv);
+    }
+    if (program == "ioDepthBench")
+    {
+        return io_depth_bench_program(argc, argv);
+    }
+
+    // sortArrays is the default program
+    return sort_arrays_program(argc, argv);
 }
\ No newline at end of file